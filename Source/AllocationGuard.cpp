@@ -0,0 +1,93 @@
+/*
+    File: AllocationGuard.cpp
+    Description: Heap hooks backing ScopedAllocationGuard and AllocationCounter. Global operator
+    new/delete are replaced on every platform; on glibc the C allocator is interposed as well,
+    because HeapBlock (and so AudioBuffer, Array and MidiBuffer) allocates through std::malloc.
+*/
+
+#include "AllocationGuard.h"
+
+#if JUCE_DEBUG || SYNTH_COUNT_ALLOCATIONS
+ #define SYNTH_HOOK_ALLOCATOR 1
+#else
+ #define SYNTH_HOOK_ALLOCATOR 0
+#endif
+
+#if SYNTH_HOOK_ALLOCATOR
+
+#include <cstdlib>
+#include <new>
+
+#if JUCE_LINUX && defined (__GLIBC__)
+ #define SYNTH_HOOK_C_ALLOCATOR 1
+#else
+ #define SYNTH_HOOK_C_ALLOCATOR 0
+#endif
+
+namespace
+{
+    thread_local int guardDepth = 0;
+    std::atomic<int64> allocationCount { 0 };
+
+    void reportAllocation()
+    {
+        allocationCount.fetch_add (1, std::memory_order_relaxed);
+
+        if (guardDepth > 0)
+        {
+            //the assertion handler may allocate itself, so drop the guard while it runs
+            const auto depth = guardDepth;
+            guardDepth = 0;
+            jassertfalse; // heap allocation inside a ScopedAllocationGuard (the audio callback)
+            guardDepth = depth;
+        }
+    }
+}
+
+//==============================================================================
+#if JUCE_DEBUG
+ScopedAllocationGuard::ScopedAllocationGuard()  { ++guardDepth; }
+ScopedAllocationGuard::~ScopedAllocationGuard() { --guardDepth; }
+int ScopedAllocationGuard::getDepth()           { return guardDepth; }
+#endif
+
+int64 AllocationCounter::getCount() noexcept    { return allocationCount.load (std::memory_order_relaxed); }
+bool AllocationCounter::isAvailable() noexcept  { return true; }
+
+//==============================================================================
+#if SYNTH_HOOK_C_ALLOCATOR
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+
+    void* malloc (size_t size) noexcept                 { reportAllocation(); return __libc_malloc (size); }
+    void* calloc (size_t num, size_t size) noexcept     { reportAllocation(); return __libc_calloc (num, size); }
+    void* realloc (void* ptr, size_t size) noexcept     { reportAllocation(); return __libc_realloc (ptr, size); }
+}
+#endif
+
+void* operator new (std::size_t size)
+{
+   #if ! SYNTH_HOOK_C_ALLOCATOR
+    reportAllocation();
+   #endif
+
+    if (auto* ptr = std::malloc (size > 0 ? size : 1))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)     { return operator new (size); }
+void operator delete (void* ptr) noexcept   { std::free (ptr); }
+void operator delete[] (void* ptr) noexcept { std::free (ptr); }
+void operator delete (void* ptr, std::size_t) noexcept   { std::free (ptr); }
+void operator delete[] (void* ptr, std::size_t) noexcept { std::free (ptr); }
+
+#else
+
+int64 AllocationCounter::getCount() noexcept    { return 0; }
+bool AllocationCounter::isAvailable() noexcept  { return false; }
+#endif
@@ -0,0 +1,37 @@
+/*
+    File: AllocationGuard.h
+    Description: Debug-only guard that asserts when the current thread allocates heap memory
+    while a ScopedAllocationGuard is alive. Used to keep the audio callback allocation-free.
+    In release builds the guard compiles away to nothing.
+
+    The same heap hooks keep a process-wide allocation count. Release builds can keep the hooks
+    (without the assertion) by defining SYNTH_COUNT_ALLOCATIONS=1, as the benchmarks do.
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+struct ScopedAllocationGuard
+{
+#if JUCE_DEBUG
+    ScopedAllocationGuard();
+    ~ScopedAllocationGuard();
+
+    //number of guards alive on the calling thread
+    static int getDepth();
+#else
+    ScopedAllocationGuard() {}
+#endif
+
+    JUCE_DECLARE_NON_COPYABLE (ScopedAllocationGuard)
+};
+
+//==============================================================================
+struct AllocationCounter
+{
+    //heap allocations made by any thread since startup; always 0 when the hooks aren't built
+    static int64 getCount() noexcept;
+    static bool isAvailable() noexcept;
+};
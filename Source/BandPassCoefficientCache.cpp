@@ -0,0 +1,38 @@
+/*
+    File: BandPassCoefficientCache.cpp
+    Description: See BandPassCoefficientCache.h
+*/
+
+#include "BandPassCoefficientCache.h"
+
+bool BandPassCoefficientCache::update (double sampleRate, double frequency, double q, float* coefs) noexcept
+{
+    if (sampleRate == lastSampleRate && frequency == lastFrequency && q == lastQ)
+        return false;
+
+    lastSampleRate = sampleRate;
+    lastFrequency = frequency;
+    lastQ = q;
+
+    calculate (sampleRate, frequency, q, coefs);
+    return true;
+}
+
+void BandPassCoefficientCache::calculate (double sampleRate, double frequency, double q, float* coefs) noexcept
+{
+    auto n = 1.0 / std::tan (MathConstants<double>::pi * frequency / sampleRate);
+    auto nSquared = n * n;
+    auto invQ = 1.0 / q;
+    auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+    coefs[0] = (float) (c1 * n * invQ);
+    coefs[1] = 0.0f;
+    coefs[2] = (float) (-c1 * n * invQ);
+    coefs[3] = (float) (c1 * 2.0 * (1.0 - nSquared));
+    coefs[4] = (float) (c1 * (1.0 - invQ * n + nSquared));
+}
+
+void BandPassCoefficientCache::invalidate() noexcept
+{
+    lastSampleRate = 0.0;
+}
@@ -0,0 +1,32 @@
+/*
+    File: BandPassCoefficientCache.h
+    Description: Memoised band-pass coefficients for a voice's biquad. Uses the same RBJ maths as
+    dsp::IIR::Coefficients::makeBandPass, but writes into an existing coefficient array and only
+    runs the trig when the frequency, Q or sample rate actually changed.
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class BandPassCoefficientCache
+{
+public:
+    BandPassCoefficientCache() {}
+
+    //writes b0, b1, b2, a1, a2 (normalised by a0) into coefs if any parameter differs from
+    //the previous call; returns true when the coefficients were recomputed
+    bool update (double sampleRate, double frequency, double q, float* coefs) noexcept;
+
+    //forces the next update to recompute, e.g. after the filter state was replaced
+    void invalidate() noexcept;
+
+    //the same coefficients, always computed
+    static void calculate (double sampleRate, double frequency, double q, float* coefs) noexcept;
+
+private:
+    double lastSampleRate = 0.0, lastFrequency = 0.0, lastQ = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BandPassCoefficientCache)
+};
@@ -0,0 +1,46 @@
+/*
+    File: CpuDispatch.h
+    Description: Optional runtime CPU dispatch for the hot kernels. A build that defines
+    SYNTH_CPU_DISPATCH=1 (the CMake option of the same name) for x86-64 with GCC or Clang, and
+    that isn't already targeting AVX2 through -march, compiles the marked kernels once per
+    instruction set and picks the best one the CPU has at run time. One portable binary then still
+    gets AVX2 on the machines that have it. Everywhere else the macros expand to nothing and the
+    kernels compile exactly as before.
+
+    Only instruction sets that don't change the arithmetic are listed (no FMA), so every variant
+    produces bit-identical output.
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#if SYNTH_CPU_DISPATCH && JUCE_INTEL && JUCE_64BIT && (JUCE_GCC || JUCE_CLANG) && ! defined (__AVX2__)
+ #define SYNTH_DISPATCH_AVX2 1
+
+ //a single hand-written variant, chosen with CpuDispatch::hasAVX2()
+ #define SYNTH_TARGET_AVX2 __attribute__ ((target ("avx2")))
+
+ //compiler-vectorised loops: one clone per target, resolved once by the loader (glibc ifunc)
+ #if JUCE_LINUX
+  #define SYNTH_TARGET_CLONES __attribute__ ((target_clones ("avx2", "sse4.2", "default")))
+ #endif
+#else
+ #define SYNTH_DISPATCH_AVX2 0
+ #define SYNTH_TARGET_AVX2
+#endif
+
+#ifndef SYNTH_TARGET_CLONES
+ #define SYNTH_TARGET_CLONES
+#endif
+
+//==============================================================================
+struct CpuDispatch
+{
+    //checked once, on first use
+    static bool hasAVX2() noexcept
+    {
+        static const bool result = SystemStats::hasAVX2();
+        return result;
+    }
+};
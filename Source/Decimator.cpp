@@ -0,0 +1,194 @@
+/*
+    File: Decimator.cpp
+    Description: See Decimator.h
+*/
+
+#include "Decimator.h"
+#include "CpuDispatch.h"
+
+namespace
+{
+    //taps either side of the centre for the last stage, which sets the passband: with the Kaiser
+    //window below, flat to about 0.45 of the output rate and at least 70 dB down wherever it
+    //would alias back below 0.42 of it
+    constexpr int finalStagePairs = 16;
+
+    //an earlier stage only has to keep its images out of what the last stage passes, which
+    //leaves it a transition band several times wider and so far fewer taps
+    constexpr int earlyStagePairs = 6;
+
+    constexpr double kaiserBeta = 8.0;
+
+    //the zeroth-order modified Bessel function, by its power series
+    double besselI0 (double x) noexcept
+    {
+        double sum = 1.0, term = 1.0;
+
+        for (int k = 1; k < 64 && term > 1.0e-12 * sum; ++k)
+        {
+            auto ratio = x / (2.0 * k);
+            term *= ratio * ratio;
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    //a Kaiser-windowed sinc cut off at a quarter of the input rate, with 4 numPairs - 1 taps. all
+    //the taps an even distance from the centre are zero bar the centre itself, 0.5; the numPairs
+    //taps on one side at odd distances, outermost first, go to taps. normalised for unity at DC
+    void designHalfBand (float* taps, int numPairs) noexcept
+    {
+        auto numTaps = 4 * numPairs - 1;
+        auto centre = 2 * numPairs - 1;
+        double designed[64];
+        double sum = 0.0;
+
+        jassert (numPairs <= 64);
+
+        for (int j = 0; j < numPairs; ++j)
+        {
+            auto n = 2 * j;
+            auto offset = (double) (n - centre);
+            auto x = 2.0 * n / (numTaps - 1) - 1.0;
+            auto window = besselI0 (kaiserBeta * std::sqrt (1.0 - x * x)) / besselI0 (kaiserBeta);
+
+            designed[j] = std::sin (MathConstants<double>::pi * offset * 0.5) / (MathConstants<double>::pi * offset) * window;
+            sum += designed[j];
+        }
+
+        //both sides together make up the half of the DC gain the centre tap doesn't
+        for (int j = 0; j < numPairs; ++j)
+            taps[j] = (float) (designed[j] * 0.25 / sum);
+    }
+
+    //the polyphase form of the half-band: output m is 0.5 odd[m] plus, for each pair of mirrored
+    //taps, taps[j] * (even[m + j] + even[m + 2 numPairs - 1 - j]). each tap is a pass over the
+    //whole block, which the compiler vectorises
+    SYNTH_TARGET_CLONES
+    void decimateHalfBand (const float* even, const float* odd, const float* taps, int numPairs,
+                           float* output, int numOutputSamples) noexcept
+    {
+        for (int m = 0; m < numOutputSamples; ++m)
+            output[m] = 0.5f * odd[m];
+
+        for (int j = 0; j < numPairs; ++j)
+        {
+            auto tap = taps[j];
+            auto* early = even + j;
+            auto* late = even + 2 * numPairs - 1 - j;
+
+            for (int m = 0; m < numOutputSamples; ++m)
+                output[m] += tap * (early[m] + late[m]);
+        }
+    }
+}
+
+//==============================================================================
+Decimator::Stage::Stage (int pairs, int maximumOutputBlockSize, int numChannels)
+    : numPairs (pairs),
+      taps ((size_t) pairs),
+      evens (numChannels, 2 * pairs - 1 + maximumOutputBlockSize),
+      odds (numChannels, pairs + maximumOutputBlockSize)
+{
+    designHalfBand (taps, numPairs);
+    evens.clear();
+    odds.clear();
+}
+
+void Decimator::Stage::process (int channel, const float* input, float* output, int numOutputSamples) noexcept
+{
+    auto evenHistory = 2 * numPairs - 1;
+    auto oddHistory = numPairs;
+    auto* even = evens.getWritePointer (channel);
+    auto* odd = odds.getWritePointer (channel);
+
+    //the input is copied out before anything is written, so output may overlap it
+    for (int i = 0; i < numOutputSamples; ++i)
+    {
+        even[evenHistory + i] = input[2 * i];
+        odd[oddHistory + i] = input[2 * i + 1];
+    }
+
+    decimateHalfBand (even, odd, taps, numPairs, output, numOutputSamples);
+
+    //the newest samples are the next block's history
+    std::memmove (even, even + numOutputSamples, sizeof (float) * (size_t) evenHistory);
+    std::memmove (odd, odd + numOutputSamples, sizeof (float) * (size_t) oddHistory);
+}
+
+//==============================================================================
+Decimator::Decimator() {}
+Decimator::~Decimator() {}
+
+void Decimator::prepare (int newFactor, int maximumOutputBlockSize, int numChannels)
+{
+    jassert (newFactor == 1 || newFactor == 2 || newFactor == maxFactor);
+
+    factor = newFactor >= maxFactor ? maxFactor : newFactor >= 2 ? 2 : 1;
+    preparedBlockSize = maximumOutputBlockSize;
+    preparedChannels = numChannels;
+    stages.clear();
+
+    if (factor == maxFactor)
+        stages.add (new Stage (earlyStagePairs, 2 * maximumOutputBlockSize, numChannels));
+
+    if (factor > 1)
+        stages.add (new Stage (finalStagePairs, maximumOutputBlockSize, numChannels));
+}
+
+void Decimator::reset() noexcept
+{
+    for (auto* stage : stages)
+    {
+        stage->evens.clear();
+        stage->odds.clear();
+    }
+}
+
+void Decimator::swapWith (Decimator& other) noexcept
+{
+    stages.swapWith (other.stages);
+    std::swap (factor, other.factor);
+    std::swap (preparedBlockSize, other.preparedBlockSize);
+    std::swap (preparedChannels, other.preparedChannels);
+}
+
+float Decimator::getLatencyInSamples() const noexcept
+{
+    //each stage delays by half its length, at its own input rate
+    auto latency = 0.0f;
+    auto inputRate = factor;
+
+    for (auto* stage : stages)
+    {
+        latency += (float) (2 * stage->numPairs - 1) / (float) inputRate;
+        inputRate /= 2;
+    }
+
+    return latency;
+}
+
+void Decimator::process (AudioBuffer<float>& input, AudioBuffer<float>& output, int startSample, int numSamples) noexcept
+{
+    jassert (numSamples <= preparedBlockSize);
+    jassert (input.getNumSamples() >= numSamples * factor);
+
+    numSamples = jmin (numSamples, preparedBlockSize);
+    auto numChannels = jmin (input.getNumChannels(), output.getNumChannels(), preparedChannels);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        //each stage halves the block in place at the front of the input channel
+        auto* samples = input.getWritePointer (channel);
+        auto numStageSamples = numSamples * factor;
+
+        for (auto* stage : stages)
+        {
+            numStageSamples /= 2;
+            stage->process (channel, samples, samples, numStageSamples);
+        }
+
+        output.copyFrom (channel, startSample, samples, numSamples);
+    }
+}
@@ -0,0 +1,61 @@
+/*
+    File: Decimator.h
+    Description: Brings the oversampled voice mix back down to the device rate: a chain of
+    polyphase half-band FIR stages, each halving the rate. Half of a half-band filter's taps are
+    zero, and splitting the input into its even and odd samples skips them and every output that
+    would be thrown away, so a stage costs about a quarter of the equivalent plain FIR. The inner
+    loops run over whole blocks and vectorise.
+
+    The taps are linear phase, so the chain only adds a fixed delay, reported in device samples.
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class Decimator
+{
+public:
+    static constexpr int maxFactor = 4;
+
+    Decimator();
+    ~Decimator();
+
+    //factor is 1, 2 or 4; 1 just copies. sizes the history buffers, the only place the decimator
+    //allocates. never from the audio thread
+    void prepare (int factor, int maximumOutputBlockSize, int numChannels);
+    void reset() noexcept;
+
+    //trades filters and history with other, so a decimator prepared off the audio thread can
+    //be swapped in under a lock without allocating
+    void swapWith (Decimator& other) noexcept;
+
+    int getFactor() const noexcept      { return factor; }
+
+    //the delay the filters add, in output samples
+    float getLatencyInSamples() const noexcept;
+
+    //decimates the first numSamples * factor samples of each of input's channels into output,
+    //from startSample. input is used as scratch, so its contents are lost
+    void process (AudioBuffer<float>& input, AudioBuffer<float>& output, int startSample, int numSamples) noexcept;
+
+private:
+    //one 2:1 stage: a (4 numPairs - 1)-tap half-band low-pass
+    struct Stage
+    {
+        Stage (int numPairs, int maximumOutputBlockSize, int numChannels);
+
+        void process (int channel, const float* input, float* output, int numOutputSamples) noexcept;
+
+        int numPairs;
+        HeapBlock<float> taps;              //the non-zero taps either side of the centre, which is 0.5
+        AudioBuffer<float> evens, odds;     //per channel: the history, then the block's even or odd samples
+    };
+
+    OwnedArray<Stage> stages;               //in processing order, from the highest rate down
+    int factor = 1;
+    int preparedBlockSize = 0, preparedChannels = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Decimator)
+};
@@ -0,0 +1,215 @@
+/*
+    File: EnvelopeGenerator.cpp
+    Description: See EnvelopeGenerator.h
+*/
+
+#include "EnvelopeGenerator.h"
+#include "CpuDispatch.h"
+
+namespace
+{
+    //decay and release cover this fraction of their distance in their set time, then snap to
+    //the target; 0.005 matches the tail-off cut-off the voices used before
+    constexpr double segmentEndRatio = 0.005;
+
+    int secondsToSamples (float seconds, double sampleRate) noexcept
+    {
+        return jmax (1, roundToInt (seconds * sampleRate));
+    }
+}
+
+//==============================================================================
+bool EnvelopeGenerator::Parameters::operator== (const Parameters& other) const noexcept
+{
+    return attack == other.attack && decay == other.decay
+            && sustain == other.sustain && release == other.release;
+}
+
+bool EnvelopeGenerator::Parameters::operator!= (const Parameters& other) const noexcept
+{
+    return ! operator== (other);
+}
+
+//==============================================================================
+EnvelopeGenerator::EnvelopeGenerator()
+{
+    recalculateRates();
+}
+
+void EnvelopeGenerator::setSampleRate (double newSampleRate)
+{
+    jassert (newSampleRate > 0.0);
+    sampleRate = newSampleRate;
+    recalculateRates();
+}
+
+void EnvelopeGenerator::setParameters (const Parameters& newParameters)
+{
+    parameters = newParameters;
+    parameters.sustain = jlimit (0.0f, 1.0f, parameters.sustain);
+    recalculateRates();
+
+    if (state == State::sustain)
+        level = parameters.sustain;
+}
+
+void EnvelopeGenerator::recalculateRates() noexcept
+{
+    auto fillPowers = [this] (float* powers, float seconds)
+    {
+        auto coefficient = (float) std::pow (segmentEndRatio, 1.0 / secondsToSamples (seconds, sampleRate));
+        auto power = 1.0f;
+
+        for (int i = 0; i < numLanes; ++i)
+            powers[i] = (power *= coefficient);
+    };
+
+    fillPowers (decayPowers, parameters.decay);
+    fillPowers (releasePowers, parameters.release);
+}
+
+//==============================================================================
+void EnvelopeGenerator::noteOn() noexcept
+{
+    enterState (State::attack);
+}
+
+void EnvelopeGenerator::noteOff() noexcept
+{
+    if (state != State::idle)
+        enterState (State::release);
+}
+
+void EnvelopeGenerator::reset() noexcept
+{
+    level = 0.0f;
+    state = State::idle;
+}
+
+bool EnvelopeGenerator::isFadingOut() const noexcept
+{
+    return state == State::release || (state == State::sustain && parameters.sustain <= 0.0f);
+}
+
+void EnvelopeGenerator::enterState (State newState) noexcept
+{
+    state = newState;
+
+    switch (state)
+    {
+        case State::attack:
+            //a retriggered note ramps up from wherever it currently is
+            samplesLeftInSegment = secondsToSamples (parameters.attack, sampleRate);
+            linearStep = (1.0f - level) / (float) samplesLeftInSegment;
+            break;
+
+        case State::decay:
+            samplesLeftInSegment = secondsToSamples (parameters.decay, sampleRate);
+            break;
+
+        case State::release:
+            samplesLeftInSegment = secondsToSamples (parameters.release, sampleRate);
+            break;
+
+        case State::sustain:
+            level = parameters.sustain;
+            break;
+
+        case State::idle:
+        default:
+            level = 0.0f;
+            break;
+    }
+}
+
+//==============================================================================
+int EnvelopeGenerator::getNextBlock (float* dest, int numSamples) noexcept
+{
+    int pos = 0;
+
+    while (pos < numSamples)
+    {
+        auto numLeft = numSamples - pos;
+
+        switch (state)
+        {
+            case State::attack:
+                pos += fillLinear (dest + pos, numLeft);
+
+                if (samplesLeftInSegment == 0)
+                {
+                    level = 1.0f;
+                    enterState (State::decay);
+                }
+                break;
+
+            case State::decay:
+                pos += fillExponential (dest + pos, numLeft, parameters.sustain, decayPowers);
+
+                if (samplesLeftInSegment == 0)
+                    enterState (State::sustain);
+                break;
+
+            case State::sustain:
+                FloatVectorOperations::fill (dest + pos, level, numLeft);
+                pos = numSamples;
+                break;
+
+            case State::release:
+                pos += fillExponential (dest + pos, numLeft, 0.0f, releasePowers);
+
+                if (samplesLeftInSegment == 0)
+                    enterState (State::idle);
+                break;
+
+            case State::idle:
+            default:
+                FloatVectorOperations::clear (dest + pos, numLeft);
+                return pos;
+        }
+    }
+
+    return numSamples;
+}
+
+SYNTH_TARGET_CLONES
+int EnvelopeGenerator::fillLinear (float* dest, int numSamples) noexcept
+{
+    auto num = jmin (numSamples, samplesLeftInSegment);
+    auto start = level;
+    auto step = linearStep;
+
+    for (int i = 0; i < num; ++i)
+        dest[i] = start + step * (float) (i + 1);
+
+    level = start + step * (float) num;
+    samplesLeftInSegment -= num;
+    return num;
+}
+
+SYNTH_TARGET_CLONES
+int EnvelopeGenerator::fillExponential (float* dest, int numSamples, float target, const float* powers) noexcept
+{
+    //level = target + distance * coefficient^n; each group of numLanes samples is independent,
+    //so the inner loop vectorises and only the distance is carried between groups
+    auto num = jmin (numSamples, samplesLeftInSegment);
+    auto distance = level - target;
+    int i = 0;
+
+    for (; i + numLanes <= num; i += numLanes)
+    {
+        for (int lane = 0; lane < numLanes; ++lane)
+            dest[i + lane] = target + distance * powers[lane];
+
+        distance *= powers[numLanes - 1];
+    }
+
+    for (int lane = 0; i < num; ++i, ++lane)
+        dest[i] = target + distance * powers[lane];
+
+    if (i > 0)
+        level = dest[i - 1];
+
+    samplesLeftInSegment -= num;
+    return num;
+}
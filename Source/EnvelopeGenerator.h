@@ -0,0 +1,66 @@
+/*
+    File: EnvelopeGenerator.h
+    Description: Sample-accurate ADSR for the voices, run inside the audio callback. Gains are
+    written a block at a time: the attack is a linear ramp, decay and release are exponential
+    segments with a fixed length, and each segment is filled with a loop the compiler can vectorise.
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class EnvelopeGenerator
+{
+public:
+    //times are in seconds, sustain is a gain in [0, 1]
+    struct Parameters
+    {
+        float attack = 0.1f, decay = 0.1f, sustain = 1.0f, release = 0.02f;
+
+        bool operator== (const Parameters& other) const noexcept;
+        bool operator!= (const Parameters& other) const noexcept;
+    };
+
+    EnvelopeGenerator();
+
+    void setSampleRate (double newSampleRate);
+    void setParameters (const Parameters& newParameters);
+    const Parameters& getParameters() const noexcept    { return parameters; }
+
+    void noteOn() noexcept;
+    void noteOff() noexcept;
+    void reset() noexcept;
+
+    bool isActive() const noexcept                      { return state != State::idle; }
+
+    //true once the level can only fall from here: released, or holding a sustain of zero
+    bool isFadingOut() const noexcept;
+    float getCurrentLevel() const noexcept              { return level; }
+
+    //writes the next numSamples gains to dest. returns how many of them belong to the note;
+    //anything less than numSamples means the release finished and the rest of dest is zero
+    int getNextBlock (float* dest, int numSamples) noexcept;
+
+private:
+    enum class State { idle, attack, decay, sustain, release };
+
+    static constexpr int numLanes = 8;
+
+    void enterState (State newState) noexcept;
+    void recalculateRates() noexcept;
+    int fillLinear (float* dest, int numSamples) noexcept;
+    int fillExponential (float* dest, int numSamples, float target, const float* powers) noexcept;
+
+    Parameters parameters;
+    double sampleRate = 44100.0;
+    State state = State::idle;
+    float level = 0.0f;
+    float linearStep = 0.0f;
+    int samplesLeftInSegment = 0;
+
+    //coefficient^1 .. coefficient^numLanes for the decay and release curves
+    float decayPowers[numLanes], releasePowers[numLanes];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EnvelopeGenerator)
+};
@@ -27,7 +27,7 @@ public:
     {
         // This method is where you should put your application's initialisation code..
 
-        mainWindow.reset (new MainWindow (getApplicationName()));
+        mainWindow.reset (new MainWindow (getApplicationName(), commandLine));
     }
 
     void shutdown() override
@@ -60,13 +60,15 @@ public:
     class MainWindow    : public DocumentWindow
     {
     public:
-        MainWindow (String name)  : DocumentWindow (name,
-                                                    Desktop::getInstance().getDefaultLookAndFeel()
-                                                                          .findColour (ResizableWindow::backgroundColourId),
-                                                    DocumentWindow::allButtons)
+        MainWindow (String name, const String& commandLine)  : DocumentWindow (name,
+                                                                               Desktop::getInstance().getDefaultLookAndFeel()
+                                                                                                     .findColour (ResizableWindow::backgroundColourId),
+                                                                               DocumentWindow::allButtons)
         {
             setUsingNativeTitleBar (true);
-            setContentOwned (new MainComponent(), true);
+            auto* mainComponent = new MainComponent();
+            mainComponent->startPerformanceExport (StringArray::fromTokens (commandLine, true));
+            setContentOwned (mainComponent, true);
 
            #if JUCE_IOS || JUCE_ANDROID
             setFullScreen (true);
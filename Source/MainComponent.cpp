@@ -2,204 +2,27 @@
  File: MainComponent.cpp
  Date: December 26, 2018
  Author: Christopher Robinson
- Descrpition: This file contains most of the code for the Subtractive Synthesiser Audio Application. 
-    The Subtractive Synthesiser Audio Application takes in white noise and band-passes corresponding
-    to what midi notes are received. The GUI contains a qValue slider, which controls the purity of
-    the tone, and a volume slider. Additionally, there is a MidiKeyboardComponent, from which 
-    the application receives its midi information.
+ Descrpition: The GUI of the Subtractive Synthesiser Audio Application. The synthesis itself, band-passed
+    noise voices and their filters, lives in the SynthEngine library shared with the headless tools.
+    This file lays out the controls that drive it, the MIDI input list and a MidiKeyboardComponent,
+    feeds the device's audio through the engine and the output stage, and draws the performance
+    overlay.
  Version: 1.0.0
  */
 
 #include "MainComponent.h"
 
-//==============================================================================
-SynthSound::SynthSound(){}
-
-bool SynthSound::appliesToNote( int )    { return true; }
-bool SynthSound::appliesToChannel( int ) { return true; }
-
-
-//==============================================================================
-SynthVoice::SynthVoice( int samplesPerBlockExpected )
-    :bpFilter(dsp::IIR::Coefficients<float>::makeBandPass (getSampleRate(), 20000.0f, 0.0001f))
-    {
-        spec.sampleRate = getSampleRate();
-        spec.maximumBlockSize = samplesPerBlockExpected;
-        spec.numChannels = CHANNELS;
-        samplesPerBlock = samplesPerBlockExpected;
-        dsp::AudioBlock<float> block;
-        
-
-    
-    }
-
-void SynthVoice::timerCallback()
-{
-    if( attack < 1.0f ) attack += 0.01f;
-
-}
-
-
-bool SynthVoice::canPlaySound (SynthesiserSound* sound){
-        return dynamic_cast<SynthSound*> (sound) != nullptr;
-}
-
-void SynthVoice::startNote (int midiNoteNumber, float velocity,
-                            SynthesiserSound*, int /*currentPitchWheelPosition*/) {
-    
-    bpFilter.reset();
-    
-    tailOff = 0.0;
-    attack = 0.0;
-    startTimer(1);
-    //level = velocity * 0.5;
-    level = 0.5;
-    isOn = true;
-    
-    frequency = MidiMessage::getMidiNoteInHertz (midiNoteNumber);
-    
-    updateFilter();
-    bpFilter.prepare(spec);
-    
-}
-void SynthVoice::stopNote (float /*velocity*/, bool allowTailOff){
-    
-    if (allowTailOff)
-    {
-        if (tailOff == 0.0)
-            tailOff = 1.0;
-    }
-    else
-    {
-        clearCurrentNote();
-        isOn = false;
-        stopTimer();
-        bpFilter.reset();
-    }
-}
-void SynthVoice::pitchWheelMoved (int){}
-void SynthVoice::controllerMoved (int, int){}
-
-void SynthVoice::updateFilter(){
-
-    if( qVal <= 0) qVal = 0.0001;
-    
-    *bpFilter.state = *dsp::IIR::Coefficients<float>::makeBandPass (getSampleRate(), frequency, qVal);
-
-}
-void SynthVoice::renderNextBlock (AudioSampleBuffer& outputBuffer, int startSample, int numSamples)
-{
-    bufferBuffer = AudioBuffer<float>( outputBuffer.getNumChannels(), outputBuffer.getNumSamples());
-    bufferBuffer.clear();
-    
-    if( isOn )
-    {
-        int index = numSamples;
-        if (tailOff > 0.0) // with tail off
-        {
-            while (--index >= 0)
-            {
-  
-                auto currentSample = level * tailOff * attack * (-0.25f + (0.5f * (float) random.nextFloat()));
-                
-                for (auto i = bufferBuffer.getNumChannels(); --i >= 0;){
-
-                    bufferBuffer.addSample(i, startSample, currentSample);
-                }
-                ++startSample;
-            
-                tailOff *= 0.994;
-            
-                if (tailOff <= 0.005)
-                {
-                    clearCurrentNote();
-                    isOn = false;
-                    stopTimer();
-                    bpFilter.reset();
-                    break;
-                }
-            }
-        }
-        else // without tail off (tail on)
-        {
-            while (--index >= 0)
-            {
-                
-                auto currentSample = level * attack * (-0.25f + (0.5f * (float) random.nextFloat()));
-                
-                for (auto i = bufferBuffer.getNumChannels(); --i >= 0;){
-                    bufferBuffer.addSample(i, startSample, currentSample);
-
-                }
-                ++startSample;
-            }
-        }
-        dsp::AudioBlock<float> block(bufferBuffer);
-        updateFilter();
-        bpFilter.process(dsp::ProcessContextReplacing<float> (block));
-        index = numSamples;
-        while (--index >= 0){
-            for( auto i = outputBuffer.getNumChannels(); --i >= 0;){
-        
-                //bufferBuffer.setSample(i, index, bufferBuffer.getSample(i, index) * static_cast<float> (MathConstants<double>::sqrt2));
-                bufferBuffer.setSample(i, index, bufferBuffer.getSample(i, index) * (1 + qVal));
-                outputBuffer.addSample(i, index, bufferBuffer.getSample(i, index));
-            }
-        }
-    }
-}
-
-
-//==============================================================================
-SynthAudioSource::SynthAudioSource (MidiKeyboardState& keyState)
-    : keyboardState (keyState){}
-    
-    void SynthAudioSource::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
-    {
-        for (auto i = 0; i < POLYPHONY; ++i)
-            synth.addVoice (new SynthVoice( samplesPerBlockExpected ));
-        
-        synth.addSound (new SynthSound());
-        synth.setCurrentPlaybackSampleRate (sampleRate);
-        midiCollector.reset (sampleRate);
-    }
-    
-    void SynthAudioSource::releaseResources(){}
-    
-    void SynthAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill)
-    {
-        bufferToFill.clearActiveBufferRegion();
-
-            MidiBuffer incomingMidi;
-            midiCollector.removeNextBlockOfMessages (incomingMidi, bufferToFill.numSamples);
-            keyboardState.processNextMidiBuffer (incomingMidi, bufferToFill.startSample,
-                                             bufferToFill.numSamples, true);
-
-            synth.renderNextBlock (*bufferToFill.buffer, incomingMidi,
-                               bufferToFill.startSample, bufferToFill.numSamples);
-
-        
-    }
-
-    MidiMessageCollector* SynthAudioSource::getMidiCollector()
-    {
-        return &midiCollector;
-    }
-
-
 //==============================================================================
 MainComponent::MainComponent()  :
 
     keyboardComponent(keyboardState, MidiKeyboardComponent::horizontalKeyboard),
-    synthAudioSource(keyboardState),
-    volume(0.0),
-    previousSampleNumber(0)
+    performanceServer(synthAudioSource.getPerformanceMonitor())
 
 
 {
     // Make sure you set the size of the component after
     // you add any child components.
-    setSize (800, 600);
+    setSize (800, 860);
     
     //add labels
     addAndMakeVisible (midiInputListLabel);
@@ -240,15 +63,276 @@ MainComponent::MainComponent()  :
     volumeSlider.setSkewFactorFromMidPoint (0.5);
     volumeSlider.addListener (this);
 
+    //the slider works in octaves of Q; the parameter holds Q itself
     addAndMakeVisible(qValSlider);
     qValSlider.setRange (0.0001, 10.0);
     //qValSlider.setSkewFactorFromMidPoint (64.0);
+    qValSlider.setValue (std::log2 (synthAudioSource.getParameters().getValue (SynthParameters::q)), dontSendNotification);
     qValSlider.addListener (this);
     
+    //envelope sliders, times in seconds. ranges and defaults come from the parameter definitions
+    struct EnvelopeControl { Slider& slider; Label& label; const char* name; int parameterIndex; };
+    
+    for (auto control : { EnvelopeControl { attackSlider,  attackLabel,  "Attack:",  SynthParameters::attack },
+                          EnvelopeControl { decaySlider,   decayLabel,   "Decay:",   SynthParameters::decay },
+                          EnvelopeControl { sustainSlider, sustainLabel, "Sustain:", SynthParameters::sustain },
+                          EnvelopeControl { releaseSlider, releaseLabel, "Release:", SynthParameters::release } })
+    {
+        auto& definition = SynthParameters::getDefinition (control.parameterIndex);
+        
+        addAndMakeVisible (control.label);
+        control.label.setText (control.name, dontSendNotification);
+        control.label.attachToComponent (&control.slider, true);
+        
+        addAndMakeVisible (control.slider);
+        control.slider.setRange (definition.minimum, definition.maximum);
+        if (definition.maximum > 1.0f)
+            control.slider.setSkewFactorFromMidPoint (0.5);
+        control.slider.setValue (synthAudioSource.getParameters().getValue (control.parameterIndex), dontSendNotification);
+        control.slider.addListener (this);
+    }
+    
+    //voice count and what happens when they run out
+    addAndMakeVisible (polyphonyLabel);
+    polyphonyLabel.setText ("Voices:", dontSendNotification);
+    polyphonyLabel.attachToComponent (&polyphonyList, true);
+    addAndMakeVisible (polyphonyList);
+    
+    for (auto numVoices : { 8, 16, 32, 64, 128, 256 })
+        polyphonyList.addItem (String (numVoices), numVoices);
+    
+    polyphonyList.setSelectedId (SynthAudioSource::defaultPolyphony, dontSendNotification);
+    polyphonyList.onChange = [this] { synthAudioSource.setPolyphony (polyphonyList.getSelectedId()); };
+    
+    addAndMakeVisible (stealingLabel);
+    stealingLabel.setText ("Stealing:", dontSendNotification);
+    stealingLabel.attachToComponent (&stealingList, true);
+    addAndMakeVisible (stealingList);
+    
+    stealingList.addItem ("Oldest",          (int) SynthAudioSource::StealingPolicy::oldest);
+    stealingList.addItem ("Quietest",        (int) SynthAudioSource::StealingPolicy::quietest);
+    stealingList.addItem ("Lowest note",     (int) SynthAudioSource::StealingPolicy::lowestNote);
+    stealingList.addItem ("Releasing first", (int) SynthAudioSource::StealingPolicy::releasingFirst);
+    stealingList.setSelectedId ((int) synthAudioSource.getStealingPolicy(), dontSendNotification);
+    stealingList.onChange = [this]
+    {
+        synthAudioSource.setStealingPolicy ((SynthAudioSource::StealingPolicy) stealingList.getSelectedId());
+    };
+    
+    //output clipper; the soft shapes can run oversampled to keep their harmonics from aliasing
+    addAndMakeVisible (clipModeLabel);
+    clipModeLabel.setText ("Clipper:", dontSendNotification);
+    clipModeLabel.attachToComponent (&clipModeList, true);
+    addAndMakeVisible (clipModeList);
+    
+    clipModeList.addItem ("Hard",         (int) OutputStage::ClipMode::hard);
+    clipModeList.addItem ("Soft (tanh)",  (int) OutputStage::ClipMode::tanh);
+    clipModeList.addItem ("Soft (cubic)", (int) OutputStage::ClipMode::cubic);
+    clipModeList.setSelectedId ((int) outputStage.getClipMode(), dontSendNotification);
+    clipModeList.onChange = [this] { outputStage.setClipMode ((OutputStage::ClipMode) clipModeList.getSelectedId()); };
+    
+    addAndMakeVisible (oversampleButton);
+    oversampleButton.setButtonText ("2x oversampled");
+    oversampleButton.onClick = [this] { outputStage.setOversampled (oversampleButton.getToggleState()); };
+    
+    //one band-pass per voice, the same run side by side in SIMD lanes, or a resonator per note
+    addAndMakeVisible (filterEngineLabel);
+    filterEngineLabel.setText ("Engine:", dontSendNotification);
+    filterEngineLabel.attachToComponent (&filterEngineList, true);
+    addAndMakeVisible (filterEngineList);
+    
+    filterEngineList.addItem ("Per voice",        (int) SynthAudioSource::FilterEngine::perVoice);
+    filterEngineList.addItem ("SIMD filter bank", (int) SynthAudioSource::FilterEngine::simdBank);
+    filterEngineList.addItem ("Resonators",       (int) SynthAudioSource::FilterEngine::resonators);
+    filterEngineList.setSelectedId ((int) synthAudioSource.getFilterEngine(), dontSendNotification);
+    filterEngineList.onChange = [this]
+    {
+        synthAudioSource.setFilterEngine ((SynthAudioSource::FilterEngine) filterEngineList.getSelectedId());
+        updateVelocityQEnablement();
+    };
+    
+    //the rate the voices run at; the decimator's delay shows in the performance overlay
+    addAndMakeVisible (voiceRateLabel);
+    voiceRateLabel.setText ("Rate:", dontSendNotification);
+    voiceRateLabel.attachToComponent (&voiceRateList, true);
+    addAndMakeVisible (voiceRateList);
+    
+    for (auto factor : { 1, 2, 4 })
+        voiceRateList.addItem (String (factor) + "x", factor);
+    
+    voiceRateList.setSelectedId (synthAudioSource.getOversamplingFactor(), dontSendNotification);
+    voiceRateList.onChange = [this] { synthAudioSource.setOversamplingFactor (voiceRateList.getSelectedId()); };
+    
+    //the band-pass topology, part of the patch like Q
+    addAndMakeVisible (filterTypeLabel);
+    filterTypeLabel.setText ("Filter:", dontSendNotification);
+    filterTypeLabel.attachToComponent (&filterTypeList, true);
+    addAndMakeVisible (filterTypeList);
+    
+    filterTypeList.addItem ("Biquad",                (int) VoiceFilter::Topology::biquad);
+    filterTypeList.addItem ("State variable (TPT)",  (int) VoiceFilter::Topology::stateVariable);
+    filterTypeList.addItem ("Biquad, 4th order",     (int) VoiceFilter::Topology::biquad4);
+    filterTypeList.addItem ("Biquad, 8th order",     (int) VoiceFilter::Topology::biquad8);
+    filterTypeList.addItem ("Ladder",                (int) VoiceFilter::Topology::ladder);
+    filterTypeList.setSelectedId (roundToInt (synthAudioSource.getParameters().getValue (SynthParameters::filterType)),
+                                  dontSendNotification);
+    filterTypeList.onChange = [this]
+    {
+        getEditedParameters().setValue (SynthParameters::filterType, (float) filterTypeList.getSelectedId());
+        updateVelocityQEnablement();
+    };
+    
+    //stereo placement: notes are panned by pitch, or get a decorrelated noise stream per channel
+    addAndMakeVisible (spreadLabel);
+    spreadLabel.setText ("Spread:", dontSendNotification);
+    spreadLabel.attachToComponent (&spreadSlider, true);
+    addAndMakeVisible (spreadSlider);
+    spreadSlider.setRange (0.0, 1.0);
+    spreadSlider.setValue (synthAudioSource.getParameters().getValue (SynthParameters::spread), dontSendNotification);
+    spreadSlider.addListener (this);
+    
+    addAndMakeVisible (panLawLabel);
+    panLawLabel.setText ("Pan law:", dontSendNotification);
+    panLawLabel.attachToComponent (&panLawList, true);
+    addAndMakeVisible (panLawList);
+    
+    panLawList.addItem ("Balanced",       (int) SynthAudioSource::PanLaw::balanced);
+    panLawList.addItem ("Constant power", (int) SynthAudioSource::PanLaw::constantPower);
+    panLawList.addItem ("Linear",         (int) SynthAudioSource::PanLaw::linear);
+    panLawList.setSelectedId ((int) synthAudioSource.getPanLaw(), dontSendNotification);
+    panLawList.onChange = [this] { synthAudioSource.setPanLaw ((SynthAudioSource::PanLaw) panLawList.getSelectedId()); };
+    
+    addAndMakeVisible (stereoNoiseButton);
+    stereoNoiseButton.setButtonText ("Stereo noise");
+    stereoNoiseButton.onClick = [this] { synthAudioSource.setStereoNoise (stereoNoiseButton.getToggleState()); };
+    
+    //the excitation's spectrum, part of the patch
+    addAndMakeVisible (noiseColourLabel);
+    noiseColourLabel.setText ("Noise:", dontSendNotification);
+    noiseColourLabel.attachToComponent (&noiseColourList, true);
+    addAndMakeVisible (noiseColourList);
+    
+    noiseColourList.addItem ("White", (int) SynthAudioSource::NoiseColour::white);
+    noiseColourList.addItem ("Pink",  (int) SynthAudioSource::NoiseColour::pink);
+    noiseColourList.addItem ("Blue",  (int) SynthAudioSource::NoiseColour::blue);
+    noiseColourList.setSelectedId (roundToInt (synthAudioSource.getParameters().getValue (SynthParameters::noiseColour)),
+                                   dontSendNotification);
+    noiseColourList.onChange = [this]
+    {
+        getEditedParameters().setValue (SynthParameters::noiseColour, (float) noiseColourList.getSelectedId());
+    };
+    
+    //one patch for every channel, or multi-timbral with a part per channel. picking a channel edits
+    //its part with the controls above and plays it from the on-screen keyboard
+    addAndMakeVisible (partLabel);
+    partLabel.setText ("Part:", dontSendNotification);
+    partLabel.attachToComponent (&partList, true);
+    addAndMakeVisible (partList);
+    
+    partList.addItem ("All channels", 1);
+    
+    for (int part = 0; part < SynthAudioSource::numParts; ++part)
+        partList.addItem ("Channel " + String (part + 1), part + 2);
+    
+    partList.setSelectedId (1, dontSendNotification);
+    partList.onChange = [this]
+    {
+        auto part = getSelectedPart();
+        
+        synthAudioSource.setMultitimbral (part >= 0);
+        keyboardComponent.setMidiChannel (jmax (0, part) + 1);
+        partVoicesList.setEnabled (part >= 0);
+        
+        if (part >= 0)
+            partVoicesList.setSelectedId (synthAudioSource.getPartVoiceLimit (part) + 1, dontSendNotification);
+        
+        showEditedPatch();
+    };
+    
+    //the selected part's share of the voice pool; ids are the limit plus one, so "Off" can have one
+    addAndMakeVisible (partVoicesLabel);
+    partVoicesLabel.setText ("Part voices:", dontSendNotification);
+    partVoicesLabel.attachToComponent (&partVoicesList, true);
+    addAndMakeVisible (partVoicesList);
+    
+    partVoicesList.addItem ("Off", 1);
+    
+    for (auto numVoices : { 1, 2, 4, 8, 16, 32 })
+        partVoicesList.addItem (String (numVoices), numVoices + 1);
+    
+    partVoicesList.addItem ("All", SynthAudioSource::maxPolyphony + 1);
+    partVoicesList.setSelectedId (SynthAudioSource::maxPolyphony + 1, dontSendNotification);
+    partVoicesList.setEnabled (false);
+    partVoicesList.onChange = [this]
+    {
+        if (getSelectedPart() >= 0)
+            synthAudioSource.setPartVoiceLimit (getSelectedPart(), partVoicesList.getSelectedId() - 1);
+    };
+    
+    //what the wheels, pressure and CCs do to the voices
+    addAndMakeVisible (modulationLabel);
+    modulationLabel.setText ("Modulation:", dontSendNotification);
+    modulationLabel.attachToComponent (&modulationList, true);
+    addAndMakeVisible (modulationList);
+    
+    modulationList.addItem ("Off",      modulationOff);
+    modulationList.addItem ("Keyboard", modulationKeyboard);
+    modulationList.addItem ("MPE",      modulationMpe);
+    modulationList.onChange = [this] { setModulationPreset (modulationList.getSelectedId()); };
+    modulationList.setSelectedId (modulationKeyboard, dontSendNotification);
+    setModulationPreset (modulationKeyboard);
+    
+    addAndMakeVisible (controlIntervalLabel);
+    controlIntervalLabel.setText ("Control rate:", dontSendNotification);
+    controlIntervalLabel.attachToComponent (&controlIntervalList, true);
+    addAndMakeVisible (controlIntervalList);
+    
+    for (auto numSamples : { 8, 16, 32, 64 })
+        controlIntervalList.addItem (String (numSamples) + " samples", numSamples);
+    
+    controlIntervalList.setSelectedId (synthAudioSource.getControlInterval(), dontSendNotification);
+    controlIntervalList.onChange = [this] { synthAudioSource.setControlInterval (controlIntervalList.getSelectedId()); };
+    
+    //how hard a key is struck sets the note's level through the patch's curve, and opens or
+    //narrows its band by up to the velocity Q at full velocity
+    addAndMakeVisible (velocityCurveLabel);
+    velocityCurveLabel.setText ("Velocity:", dontSendNotification);
+    velocityCurveLabel.attachToComponent (&velocityCurveList, true);
+    addAndMakeVisible (velocityCurveList);
+    
+    velocityCurveList.addItem ("Linear",      (int) VelocityCurve::Shape::linear);
+    velocityCurveList.addItem ("Exponential", (int) VelocityCurve::Shape::exponential);
+    velocityCurveList.addItem ("S-curve",     (int) VelocityCurve::Shape::custom);
+    velocityCurveList.setSelectedId (roundToInt (synthAudioSource.getParameters().getValue (SynthParameters::velocityCurve)),
+                                     dontSendNotification);
+    velocityCurveList.onChange = [this]
+    {
+        getEditedParameters().setValue (SynthParameters::velocityCurve, (float) velocityCurveList.getSelectedId());
+    };
+    
+    //the custom curve: soft playing stays quiet, and the top of the range flattens out
+    using CurvePoint = VelocityCurve::CurvePoint;
+    synthAudioSource.getVelocityCurve().setCustomPoints ({ CurvePoint { 0.0f, 0.0f }, CurvePoint { 32.0f, 0.08f },
+                                                          CurvePoint { 96.0f, 0.85f }, CurvePoint { 127.0f, 1.0f } });
+    
+    addAndMakeVisible (velocityQLabel);
+    velocityQLabel.setText ("Velocity Q:", dontSendNotification);
+    velocityQLabel.attachToComponent (&velocityQSlider, true);
+    addAndMakeVisible (velocityQSlider);
+    velocityQSlider.setRange (SynthParameters::getDefinition (SynthParameters::velocityQ).minimum,
+                              SynthParameters::getDefinition (SynthParameters::velocityQ).maximum);
+    velocityQSlider.setValue (synthAudioSource.getParameters().getValue (SynthParameters::velocityQ), dontSendNotification);
+    updateVelocityQEnablement();
+    velocityQSlider.addListener (this);
+    
     addAndMakeVisible(keyboardComponent);
     keyboardState.addListener (this);
+    
+    //the output's spectrum and waveform, analysed off the audio thread
+    addAndMakeVisible (signalAnalyser);
 
-    //startTimer (400);
+    //the performance overlay and dumps refresh ten times a second
+    startTimerHz (10);
     
     // specify the number of input and output channels that we want to open
     setAudioChannels (0, CHANNELS); 
@@ -264,33 +348,33 @@ MainComponent::~MainComponent()
 //==============================================================================
 void MainComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
 {
-    startTimer (1);
-    prevSampleRate = sampleRate;
     synthAudioSource.prepareToPlay (samplesPerBlockExpected, sampleRate);
+    outputStage.prepare (samplesPerBlockExpected, CHANNELS);
+    signalAnalyser.setSampleRate (sampleRate);
 }
 
 void MainComponent::getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill)
 {
-    bufferToFill.clearActiveBufferRegion();
+    auto startCycles = PerformanceMonitor::getCycles();
     
-    synthAudioSource.getNextAudioBlock (bufferToFill); //get midi data
+    synthAudioSource.getNextAudioBlock (bufferToFill); //clears the buffer, then renders the voices
     
-    for (auto channel = 0; channel < bufferToFill.buffer->getNumChannels(); ++channel)
-    {
-        // Get a pointer to the start sample in the buffer for this audio output channel
-        auto* buffer = bufferToFill.buffer->getWritePointer (channel, bufferToFill.startSample);
-        
-        for (auto sample = 0; sample < bufferToFill.numSamples; ++sample){
-            
-            //qVal or not?
-            buffer[sample] = buffer[sample] * volume;
-            //buffer[sample] = buffer[sample] * volume / (1.0f + pow(qValSlider.getValue(),1.2));
-            if( buffer[sample] > 1.0f ) buffer[sample] = 1.0f;
-            if( buffer[sample] < -1.0f ) buffer[sample] = -1.0f;
-
-        }
-    }
-
+    const ScopedAllocationGuard noAllocation;
+    
+    //volume, Q makeup and the clipper in one pass over each channel
+    float startGain, endGain;
+    synthAudioSource.advanceOutputGain (bufferToFill.numSamples, startGain, endGain);
+    outputStage.process (*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples,
+                         startGain, endGain);
+    
+    //a copy into the analyser's ring; everything else about the display happens elsewhere
+    signalAnalyser.pushSamples (*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+    
+    auto& monitor = synthAudioSource.getPerformanceMonitor();
+    auto& record = monitor.getCurrentRecord();
+    record.callbackCycles = PerformanceMonitor::getCycles() - startCycles;
+    record.numSamples = bufferToFill.numSamples;
+    monitor.pushCurrentRecord();
 }
 
 void MainComponent::releaseResources()
@@ -298,38 +382,100 @@ void MainComponent::releaseResources()
     synthAudioSource.releaseResources ();
 }
 void MainComponent::sliderValueChanged(Slider *slider){
+    auto& parameters = getEditedParameters();
+    
     if( slider == &qValSlider ){
-        qVal = pow(2, slider->getValue());
-        //qVal = slider->getValue();
+        parameters.setValue (SynthParameters::q, (float) pow(2, slider->getValue()));
     }
     else if(slider == &volumeSlider){
-        volume = slider->getValue();
+        parameters.setValue (SynthParameters::volume, (float) slider->getValue());
+    }
+    else if(slider == &attackSlider){
+        parameters.setValue (SynthParameters::attack, (float) slider->getValue());
+    }
+    else if(slider == &decaySlider){
+        parameters.setValue (SynthParameters::decay, (float) slider->getValue());
+    }
+    else if(slider == &sustainSlider){
+        parameters.setValue (SynthParameters::sustain, (float) slider->getValue());
+    }
+    else if(slider == &releaseSlider){
+        parameters.setValue (SynthParameters::release, (float) slider->getValue());
+    }
+    else if(slider == &spreadSlider){
+        parameters.setValue (SynthParameters::spread, (float) slider->getValue());
+    }
+    else if(slider == &velocityQSlider){
+        parameters.setValue (SynthParameters::velocityQ, (float) slider->getValue());
     }
 }
 
-void MainComponent::timerCallback()
+void MainComponent::setModulationPreset (int preset)
 {
+    using Route = ModulationMatrix::Route;
+    using Source = ModulationMatrix::Source;
+    using Destination = ModulationMatrix::Destination;
     
- 
-    auto currentTime = Time::getMillisecondCounterHiRes() * 0.001 - startTime;
-    auto currentSampleNumber = (int) (currentTime * prevSampleRate);
-    
-    MidiBuffer::Iterator iterator (midiBuffer);
-    MidiMessage message;
-    int sampleNumber;
+    auto& modulation = synthAudioSource.getModulationMatrix();
+    modulation.clearRoutes();
     
-    while (iterator.getNextEvent (message, sampleNumber))
+    if (preset == modulationKeyboard)
     {
-        if (sampleNumber > currentSampleNumber)
-            break;
-        
-       // message.setTimeStamp (sampleNumber / prevSampleRate);
-
+        //the wheel bends the pitch a tone either way, the mod wheel narrows the band and
+        //pressure, for the whole channel or per key, brings the notes up
+        modulation.setRoute (0, Route { Source::pitchBend,       0, Destination::cutoff, 2.0f });
+        modulation.setRoute (1, Route { Source::controller,      1, Destination::q,      3.0f });
+        modulation.setRoute (2, Route { Source::channelPressure, 0, Destination::level,  6.0f });
+        modulation.setRoute (3, Route { Source::polyAftertouch,  0, Destination::level,  6.0f });
     }
+    else if (preset == modulationMpe)
+    {
+        //per-note bend over the MPE default of 48 semitones, pressure to level and slide to Q
+        modulation.setRoute (0, Route { Source::pitchBend,       0,  Destination::cutoff, 48.0f });
+        modulation.setRoute (1, Route { Source::channelPressure, 0,  Destination::level,  6.0f });
+        modulation.setRoute (2, Route { Source::controller,      74, Destination::q,      4.0f });
+    }
+}
+
+int MainComponent::getSelectedPart() const
+{
+    return partList.getSelectedId() - 2;
+}
+
+SynthParameters& MainComponent::getEditedParameters()
+{
+    auto part = getSelectedPart();
+    return part >= 0 ? synthAudioSource.getPartParameters (part) : synthAudioSource.getParameters();
+}
+
+void MainComponent::showEditedPatch()
+{
+    auto& parameters = getEditedParameters();
     
+    volumeSlider.setValue (parameters.getValue (SynthParameters::volume), dontSendNotification);
+    qValSlider.setValue (std::log2 (parameters.getValue (SynthParameters::q)), dontSendNotification);
+    attackSlider.setValue (parameters.getValue (SynthParameters::attack), dontSendNotification);
+    decaySlider.setValue (parameters.getValue (SynthParameters::decay), dontSendNotification);
+    sustainSlider.setValue (parameters.getValue (SynthParameters::sustain), dontSendNotification);
+    releaseSlider.setValue (parameters.getValue (SynthParameters::release), dontSendNotification);
+    spreadSlider.setValue (parameters.getValue (SynthParameters::spread), dontSendNotification);
+    filterTypeList.setSelectedId (roundToInt (parameters.getValue (SynthParameters::filterType)), dontSendNotification);
+    noiseColourList.setSelectedId (roundToInt (parameters.getValue (SynthParameters::noiseColour)), dontSendNotification);
+    velocityCurveList.setSelectedId (roundToInt (parameters.getValue (SynthParameters::velocityCurve)), dontSendNotification);
+    velocityQSlider.setValue (parameters.getValue (SynthParameters::velocityQ), dontSendNotification);
+    updateVelocityQEnablement();
+}
+
+void MainComponent::updateVelocityQEnablement()
+{
+    //the bank and the resonators share one Q, so a note's velocity can't move it; the voices
+    //filter themselves whenever the topology or multi-timbral mode rules the banks out
+    velocityQSlider.setEnabled (synthAudioSource.getEffectiveFilterEngine() == SynthAudioSource::FilterEngine::perVoice);
+}
 
-    midiBuffer.clear (previousSampleNumber, currentSampleNumber - previousSampleNumber); 
-    previousSampleNumber = currentSampleNumber;
+void MainComponent::timerCallback()
+{
+    updatePerformanceStats();
 }
 
 void MainComponent::setMidiInput (int index)
@@ -342,7 +488,7 @@ void MainComponent::setMidiInput (int index)
     if (! deviceManager.isMidiInputEnabled (newInput))
         deviceManager.setMidiInputEnabled (newInput, true);
     
-    deviceManager.addMidiInputCallback (newInput, synthAudioSource.getMidiCollector());
+    deviceManager.addMidiInputCallback (newInput, this);
     midiInputList.setSelectedId (index + 1, dontSendNotification);
     
     lastInputIndex = index;
@@ -350,29 +496,24 @@ void MainComponent::setMidiInput (int index)
 
 void MainComponent::handleIncomingMidiMessage (MidiInput* source, const MidiMessage& message)
 {
-    const ScopedValueSetter<bool> scopedInputFlag (isAddingFromMidiInput, true);
+    //straight to the audio thread from the MIDI thread, stamped with its arrival time; the
+    //keyboard only shows it
+    synthAudioSource.getMidiQueue().push (message);
     keyboardState.processNextMidiEvent (message);
-    //postMessageToList (message, source->getName());
 }
 
+//notes played on the on-screen keyboard arrive on the message thread; the ones echoed from a
+//MIDI input arrive on its thread and have already been queued
 void MainComponent::handleNoteOn (MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity)
 {
-    if (! isAddingFromMidiInput)
-    {
-        MidiMessage m (MidiMessage::noteOn (midiChannel, midiNoteNumber, 1.0f));
-        m.setTimeStamp (Time::getMillisecondCounterHiRes() * 0.001);
-        addMessageToBuffer (m);
-    }
+    if (MessageManager::getInstance()->isThisTheMessageThread())
+        synthAudioSource.getMidiQueue().push (MidiMessage::noteOn (midiChannel, midiNoteNumber, velocity));
 }
 
 void MainComponent::handleNoteOff (MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity)
 {
-    if (! isAddingFromMidiInput)
-    {
-        MidiMessage m (MidiMessage::noteOff (midiChannel, midiNoteNumber, 1.0f));
-        m.setTimeStamp (Time::getMillisecondCounterHiRes() * 0.001);
-        addMessageToBuffer (m);
-    }
+    if (MessageManager::getInstance()->isThisTheMessageThread())
+        synthAudioSource.getMidiQueue().push (MidiMessage::noteOff (midiChannel, midiNoteNumber, velocity));
 }
 
 void MainComponent::comboBoxChanged (ComboBox* box)
@@ -381,11 +522,43 @@ void MainComponent::comboBoxChanged (ComboBox* box)
         setMidiInput (midiInputList.getSelectedItemIndex());
 }
 
-void MainComponent::addMessageToBuffer (const MidiMessage& message)
+void MainComponent::startPerformanceExport (const StringArray& args)
 {
-    auto timestamp = message.getTimeStamp();
-    auto sampleNumber =  (int) (timestamp * prevSampleRate);
-    midiBuffer.addEvent (message, sampleNumber);
+    auto valueAfter = [&args] (const String& option) { return args[args.indexOf (option) + 1]; };
+    auto& monitor = synthAudioSource.getPerformanceMonitor();
+    
+    if (args.contains ("--perf-csv"))
+        monitor.startCsvLog (File::getCurrentWorkingDirectory().getChildFile (valueAfter ("--perf-csv")));
+    
+    if (args.contains ("--perf-json"))
+        performanceJsonFile = File::getCurrentWorkingDirectory().getChildFile (valueAfter ("--perf-json"));
+    
+    if (args.contains ("--perf-port"))
+        performanceServer.start (valueAfter ("--perf-port").getIntValue());
+}
+
+void MainComponent::updatePerformanceStats()
+{
+    auto& monitor = synthAudioSource.getPerformanceMonitor();
+    
+    //AudioAppComponent's own device manager, not the one used for MIDI input
+    if (auto* device = AudioAppComponent::deviceManager.getCurrentAudioDevice())
+        monitor.setDeviceXRuns (device->getXRunCount());
+    
+    monitor.update();
+    
+    if (performanceJsonFile != File() && ++performanceUpdatesSinceJson >= 10)
+    {
+        performanceUpdatesSinceJson = 0;
+        monitor.writeJSON (performanceJsonFile);
+    }
+    
+    repaint (getPerformanceOverlayBounds());
+}
+
+Rectangle<int> MainComponent::getPerformanceOverlayBounds() const
+{
+    return { 10, 540, getWidth() - 20, 140 };
 }
 
 //==============================================================================
@@ -394,7 +567,42 @@ void MainComponent::paint (Graphics& g)
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll (getLookAndFeel().findColour (ResizableWindow::backgroundColourId));
 
-    // You can add your drawing code here!
+    //performance overlay: callback load against the block's deadline, over the last few seconds
+    auto stats = synthAudioSource.getPerformanceMonitor().getSnapshot();
+    auto area = getPerformanceOverlayBounds();
+    
+    g.setColour (Colours::black.withAlpha (0.4f));
+    g.fillRect (area);
+    
+    auto textArea = area.reduced (8).removeFromLeft (300);
+    g.setColour (Colours::white);
+    g.setFont (13.0f);
+    
+    String text;
+    text << "Callback load: " << String (stats.averageLoad * 100.0, 1) << "% avg, "
+         << String (stats.p99Load * 100.0, 1) << "% p99, " << String (stats.maxLoad * 100.0, 1) << "% max" << newLine
+         << "Synth load: " << String (stats.synthLoad * 100.0, 1) << "%" << newLine
+         << "Voice render: " << String (stats.averageVoiceMicroseconds, 1) << " us avg, "
+         << String (stats.maxVoiceMicroseconds, 1) << " us max" << newLine
+         << "Active voices: " << stats.activeVoices << newLine
+         << "Added latency: " << String (synthAudioSource.getLatencyInSamples() + outputStage.getLatencyInSamples(), 1)
+         << " samples" << newLine
+         << "Xruns: " << (stats.deviceXRuns >= 0 ? String (stats.deviceXRuns) : String ("n/a"))
+         << " device, " << String (stats.deadlineMisses) << " over deadline";
+    
+    g.drawMultiLineText (text, textArea.getX(), textArea.getY() + 12, textArea.getWidth());
+    
+    //load histogram in 5% bins, the last bin red for blocks that missed their deadline
+    auto histogramArea = area.reduced (8).withTrimmedLeft (310).toFloat();
+    auto binWidth = histogramArea.getWidth() / PerformanceMonitor::Snapshot::numHistogramBins;
+    auto largestBin = jmax (1, *std::max_element (std::begin (stats.histogram), std::end (stats.histogram)));
+    
+    for (int i = 0; i < PerformanceMonitor::Snapshot::numHistogramBins; ++i)
+    {
+        auto height = histogramArea.getHeight() * stats.histogram[i] / (float) largestBin;
+        g.setColour (i == PerformanceMonitor::Snapshot::numHistogramBins - 1 ? Colours::red : Colours::lightgreen);
+        g.fillRect (histogramArea.getX() + i * binWidth, histogramArea.getBottom() - height, binWidth - 1.0f, height);
+    }
 }
 
 void MainComponent::resized()
@@ -402,10 +610,32 @@ void MainComponent::resized()
     // This is called when the MainContentComponent is resized.
     // If you add any child components, this is where you should
     // update their positions.
-    midiInputList.setBounds(100, 25, getWidth() - 150, 20);
+    midiInputList.setBounds(100, 25, getWidth() - 470, 20);
+    partList.setBounds (490, 25, 120, 20);
+    partVoicesList.setBounds (700, 25, 80, 20);
     volumeSlider.setBounds (100, 70, getWidth() - 120, 20);
     qValSlider.setBounds (100, 100, getWidth() - 120, 20);
-    keyboardComponent.setBounds (10, 140, getWidth() - 20, 120);
+    attackSlider.setBounds (100, 130, getWidth() - 120, 20);
+    decaySlider.setBounds (100, 160, getWidth() - 120, 20);
+    sustainSlider.setBounds (100, 190, getWidth() - 120, 20);
+    releaseSlider.setBounds (100, 220, getWidth() - 120, 20);
+    spreadSlider.setBounds (100, 250, getWidth() - 120, 20);
+    polyphonyList.setBounds (100, 280, 120, 20);
+    stealingList.setBounds (310, 280, 160, 20);
+    panLawList.setBounds (560, 280, 140, 20);
+    clipModeList.setBounds (100, 310, 120, 20);
+    oversampleButton.setBounds (230, 310, 150, 20);
+    stereoNoiseButton.setBounds (390, 310, 150, 20);
+    noiseColourList.setBounds (600, 310, 100, 20);
+    filterTypeList.setBounds (100, 340, 180, 20);
+    filterEngineList.setBounds (360, 340, 160, 20);
+    voiceRateList.setBounds (580, 340, 70, 20);
+    modulationList.setBounds (100, 370, 120, 20);
+    controlIntervalList.setBounds (310, 370, 110, 20);
+    velocityCurveList.setBounds (500, 370, 120, 20);
+    velocityQSlider.setBounds (100, 400, getWidth() - 120, 20);
+    keyboardComponent.setBounds (10, 430, getWidth() - 20, 100);
+    signalAnalyser.setBounds (10, 690, getWidth() - 20, 160);
 
     
 }
@@ -8,78 +8,9 @@
 #pragma once
 
 #include "../JuceLibraryCode/JuceHeader.h"
-#define POLYPHONY 8
-#define CHANNELS 2
-
-//global qVal, so SynthVoice can access and Slider in MainComponent can update
-static double qVal = 0.0;
-
-//==============================================================================
-
-
-
-//==============================================================================
-struct SynthSound   : public SynthesiserSound
-{
-public:
-    SynthSound();
-    
-    bool appliesToNote    (int) override;
-    bool appliesToChannel (int) override;
-};
-
-//==============================================================================
-struct SynthVoice   : public SynthesiserVoice,
-                    private Timer
-
-{
-public:
-    //SynthVoice();
-    SynthVoice( int samplesPerBlockExpected );
-    void timerCallback() override;
-    bool canPlaySound (SynthesiserSound* sound) override;
-    void startNote (int midiNoteNumber, float velocity,
-                    SynthesiserSound*, int /*currentPitchWheelPosition*/) override;
-    void stopNote (float /*velocity*/, bool allowTailOff) override;
-    void pitchWheelMoved (int) override;
-    void controllerMoved (int, int) override;
-    void renderNextBlock (AudioSampleBuffer& outputBuffer, int startSample, int numSamples) override;
-    void updateFilter();
-    
-    dsp::ProcessSpec spec;
-    
-private:
-    double level = 0.0, tailOff = 0.0, attack = 0.0;
-    double lastSample[2];
-    bool isOn = false;
-    Random random;
-    double frequency;
-    AudioSampleBuffer bufferBuffer;
-    ReferenceCountedObjectPtr<dsp::IIR::Coefficients<float>> coefPtr;
-    
-    //juce::dsp::ProcessorDuplicator<dsp::StateVariableFilter::Filter<float>, dsp::StateVariableFilter::Parameters<float>> bpFilter;
-    juce::dsp::ProcessorDuplicator<dsp::IIR::Filter<float>, dsp::IIR::Coefficients<float>> bpFilter;
-    int samplesPerBlock;
-
-};
-
-//==============================================================================
-class SynthAudioSource   : public AudioSource
-{
-public:
-    SynthAudioSource (MidiKeyboardState& keyState);
-    
-    void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
-    void releaseResources() override;
-    void getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill) override;
-    MidiMessageCollector* getMidiCollector();
-    
-private:
-    MidiKeyboardState& keyboardState;
-    Synthesiser synth;
-    MidiMessageCollector midiCollector;
-
-};
+#include "SynthEngine.h"
+#include "PerformanceServer.h"
+#include "SignalAnalyser.h"
 
 //==============================================================================
 class MainComponent   : public AudioAppComponent,
@@ -105,30 +36,72 @@ public:
     void handleNoteOn (MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity) override;
     void handleNoteOff (MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity) override;
     void comboBoxChanged (ComboBox* box) override;
-    void addMessageToBuffer (const MidiMessage& message);
+    
+    //optional exports: --perf-csv <file> logs every block, --perf-json <file> rewrites a summary
+    //once a second and --perf-port <n> answers UDP requests with OSC
+    void startPerformanceExport (const StringArray& args);
     
     ComboBox midiInputList;
     AudioDeviceManager deviceManager;
     int lastInputIndex = 0;
-    bool isAddingFromMidiInput = false;
     
 
 
 private:
     void timerCallback() override;
+    void updatePerformanceStats();
+    Rectangle<int> getPerformanceOverlayBounds() const;
+    
+    //the master patch, or the selected part's in multi-timbral mode
+    SynthParameters& getEditedParameters();
+    void showEditedPatch();
+    void updateVelocityQEnablement();
+    int getSelectedPart() const;
+    
+    //the modulation list's routings
+    enum { modulationOff = 1, modulationKeyboard, modulationMpe };
+    void setModulationPreset (int preset);
     Slider volumeSlider;
     MidiKeyboardState keyboardState;
     MidiKeyboardComponent keyboardComponent;
     SynthAudioSource synthAudioSource;
-    float volume;
     Slider qValSlider;
     Label qValLabel;
     Label volumeLabel;
     Label midiInputListLabel;
-    double prevSampleRate;
-    MidiBuffer midiBuffer;
-    double startTime;
-    int previousSampleNumber;
+    Slider attackSlider, decaySlider, sustainSlider, releaseSlider;
+    Label attackLabel, decayLabel, sustainLabel, releaseLabel;
+    ComboBox polyphonyList, stealingList;
+    Label polyphonyLabel, stealingLabel;
+    OutputStage outputStage;
+    ComboBox clipModeList;
+    Label clipModeLabel;
+    ToggleButton oversampleButton;
+    ComboBox filterEngineList;
+    Label filterEngineLabel;
+    ComboBox voiceRateList;
+    Label voiceRateLabel;
+    ComboBox filterTypeList;
+    Label filterTypeLabel;
+    Slider spreadSlider;
+    Label spreadLabel;
+    ComboBox panLawList;
+    Label panLawLabel;
+    ToggleButton stereoNoiseButton;
+    ComboBox noiseColourList;
+    Label noiseColourLabel;
+    ComboBox partList, partVoicesList;
+    Label partLabel, partVoicesLabel;
+    ComboBox modulationList, controlIntervalList;
+    Label modulationLabel, controlIntervalLabel;
+    ComboBox velocityCurveList;
+    Label velocityCurveLabel;
+    Slider velocityQSlider;
+    Label velocityQLabel;
+    SignalAnalyser signalAnalyser;
+    PerformanceServer performanceServer;
+    File performanceJsonFile;
+    int performanceUpdatesSinceJson = 0;
 
 
 
@@ -0,0 +1,146 @@
+/*
+    File: MidiEventQueue.cpp
+    Description: See MidiEventQueue.h
+*/
+
+#include "MidiEventQueue.h"
+
+namespace
+{
+    //further than this from the current time, a timestamp must be on some other clock
+    constexpr double maxTimestampSkew = 1.0;
+
+    //the block start times follow the earliest the callbacks arrive, so every event stamped
+    //before a block's start has been pushed by the time that block is rendered. a callback
+    //that comes early, or more than maxClockError late (the first block, a dropout, a device
+    //restart), resets the clock; a slightly late one only nudges it
+    constexpr double maxClockError = 0.05;
+    constexpr double clockCorrection = 0.01;
+}
+
+MidiEventQueue::MidiEventQueue (int capacity)
+{
+    auto size = (uint32) nextPowerOfTwo (jmax (2, capacity));
+
+    cells.reset (new Cell[size]);
+    mask = size - 1;
+
+    for (uint32 i = 0; i < size; ++i)
+        cells[i].sequence.store (i, std::memory_order_relaxed);
+
+    pending.malloc (size);
+}
+
+MidiEventQueue::~MidiEventQueue() {}
+
+//==============================================================================
+bool MidiEventQueue::push (const MidiMessage& message) noexcept
+{
+    auto size = message.getRawDataSize();
+
+    if (size <= 0 || size > 3)
+        return true;
+
+    Event event;
+    auto now = Time::getMillisecondCounterHiRes() * 0.001;
+    event.time = std::abs (message.getTimeStamp() - now) <= maxTimestampSkew ? message.getTimeStamp() : now;
+    event.size = (uint8) size;
+    memcpy (event.data, message.getRawData(), (size_t) size);
+
+    //claim a ticket; the cell it maps to is free once its sequence has caught up with it
+    auto position = enqueuePosition.load (std::memory_order_relaxed);
+    Cell* cell;
+
+    for (;;)
+    {
+        cell = &cells[position & mask];
+        auto difference = (int32) (cell->sequence.load (std::memory_order_acquire) - position);
+
+        if (difference == 0)
+        {
+            if (enqueuePosition.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (difference < 0)
+        {
+            ++numDropped;
+            return false;
+        }
+        else
+        {
+            position = enqueuePosition.load (std::memory_order_relaxed);
+        }
+    }
+
+    cell->event = event;
+    cell->sequence.store (position + 1, std::memory_order_release);
+    return true;
+}
+
+bool MidiEventQueue::pop (Event& event) noexcept
+{
+    auto& cell = cells[dequeuePosition & mask];
+
+    if ((int32) (cell.sequence.load (std::memory_order_acquire) - (dequeuePosition + 1)) < 0)
+        return false;
+
+    event = cell.event;
+    cell.sequence.store (dequeuePosition + mask + 1, std::memory_order_release);
+    ++dequeuePosition;
+    return true;
+}
+
+//==============================================================================
+void MidiEventQueue::prepare (double newSampleRate) noexcept
+{
+    sampleRate = newSampleRate;
+    blockDuration = 0.0;
+}
+
+void MidiEventQueue::updateClock (int numSamples) noexcept
+{
+    auto now = Time::getMillisecondCounterHiRes() * 0.001;
+    auto predicted = blockStartTime + blockDuration;
+
+    if (blockDuration <= 0.0 || now < predicted || now - predicted > maxClockError)
+        blockStartTime = now;
+    else
+        blockStartTime = predicted + clockCorrection * (now - predicted);
+
+    blockDuration = numSamples / sampleRate;
+}
+
+void MidiEventQueue::removeNextBlockOfMessages (MidiBuffer& dest, int startSample, int numSamples) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    updateClock (numSamples);
+
+    //this block plays what arrived during the previous block's span of wall-clock time
+    auto windowStart = blockStartTime - blockDuration;
+
+    Event event;
+
+    while (numPending <= (int) mask && pop (event))
+        pending[numPending++] = event;
+
+    int numStillPending = 0;
+
+    for (int i = 0; i < numPending; ++i)
+    {
+        auto& e = pending[i];
+
+        if (e.time >= blockStartTime)
+        {
+            pending[numStillPending++] = e;
+            continue;
+        }
+
+        //late events (from before the window) go at the start of the block
+        auto offset = jlimit (0, numSamples - 1, (int) ((e.time - windowStart) * sampleRate));
+        dest.addEvent (e.data, e.size, startSample + offset);
+    }
+
+    numPending = numStillPending;
+}
@@ -0,0 +1,82 @@
+/*
+    File: MidiEventQueue.h
+    Description: Lock-free hand-off of live MIDI from the input threads to the audio thread, in
+    place of MidiMessageCollector and its lock. Any number of threads (MIDI input callbacks, the
+    on-screen keyboard) push short messages into a bounded multi-producer ring; the audio thread
+    drains it once per block.
+
+    Each message keeps the time it arrived at. The audio thread maps those times onto its own
+    sample clock: everything that arrived during one block's worth of wall-clock time is played
+    in the next block at the same relative offset, so events are delayed by exactly one block
+    instead of being bunched up at block starts. The block start times track the earliest the
+    callbacks arrive rather than each one, so callback jitter doesn't leak into the event timing.
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class MidiEventQueue   : public MidiInputCallback
+{
+public:
+    static constexpr int defaultCapacity = 1024;
+
+    //capacity is rounded up to a power of two; it bounds how many events can be waiting
+    explicit MidiEventQueue (int capacity = defaultCapacity);
+    ~MidiEventQueue();
+
+    //any thread, never blocks. the message's timestamp is in seconds on the
+    //Time::getMillisecondCounterHiRes() clock, as MidiInput stamps them; 0 means now. messages
+    //longer than three bytes (sysex) are ignored. returns false if the queue was full
+    bool push (const MidiMessage& message) noexcept;
+
+    //MidiInputCallback, so the queue can be registered with an AudioDeviceManager directly
+    void handleIncomingMidiMessage (MidiInput*, const MidiMessage& message) override     { push (message); }
+
+    //audio thread, before playback. restarts the clock; anything still waiting is played at
+    //the start of the next block
+    void prepare (double sampleRate) noexcept;
+
+    //audio thread. advances the clock by one block and adds every event that falls in it to
+    //dest, at startSample plus its offset into the block. events that belong to a later block
+    //stay queued
+    void removeNextBlockOfMessages (MidiBuffer& dest, int startSample, int numSamples) noexcept;
+
+    //messages pushed while the queue was full, since construction
+    int getNumDropped() const noexcept      { return numDropped.load(); }
+
+private:
+    struct Event
+    {
+        double time;            //seconds
+        uint8 data[3];
+        uint8 size;
+    };
+
+    //a bounded multi-producer queue after Dmitry Vyukov: each cell's sequence number tells a
+    //producer whether the cell is free for its ticket and the consumer whether it's filled
+    struct Cell
+    {
+        std::atomic<uint32> sequence;
+        Event event;
+    };
+
+    bool pop (Event& event) noexcept;
+    void updateClock (int numSamples) noexcept;
+
+    std::unique_ptr<Cell[]> cells;
+    uint32 mask;
+    std::atomic<uint32> enqueuePosition { 0 };
+    uint32 dequeuePosition = 0;
+    std::atomic<int> numDropped { 0 };
+
+    //audio thread only: events already popped but due in a later block
+    HeapBlock<Event> pending;
+    int numPending = 0;
+
+    double sampleRate = 44100.0;
+    double blockStartTime = 0.0, blockDuration = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiEventQueue)
+};
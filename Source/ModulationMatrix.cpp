@@ -0,0 +1,193 @@
+/*
+    File: ModulationMatrix.cpp
+    Description: See ModulationMatrix.h
+*/
+
+#include "ModulationMatrix.h"
+
+namespace
+{
+    bool parseSource (const String& name, ModulationMatrix::Route& route)
+    {
+        using Source = ModulationMatrix::Source;
+
+        if (name == "bend")             route.source = Source::pitchBend;
+        else if (name == "pressure")    route.source = Source::channelPressure;
+        else if (name == "aftertouch")  route.source = Source::polyAftertouch;
+        else if (name.startsWith ("cc"))
+        {
+            auto number = name.substring (2);
+
+            if (number.isEmpty() || ! number.containsOnly ("0123456789") || number.getIntValue() > 127)
+                return false;
+
+            route.source = Source::controller;
+            route.controllerNumber = number.getIntValue();
+        }
+        else
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+    bool parseDestination (const String& name, ModulationMatrix::Route& route)
+    {
+        using Destination = ModulationMatrix::Destination;
+
+        if (name == "cutoff")       route.destination = Destination::cutoff;
+        else if (name == "q")       route.destination = Destination::q;
+        else if (name == "level")   route.destination = Destination::level;
+        else                        return false;
+
+        return true;
+    }
+}
+
+//==============================================================================
+ModulationMatrix::ModulationMatrix() {}
+ModulationMatrix::~ModulationMatrix() {}
+
+void ModulationMatrix::setRoute (int slot, const Route& newRoute) noexcept
+{
+    jassert (isPositiveAndBelow (slot, numSlots));
+
+    if (! isPositiveAndBelow (slot, numSlots))
+        return;
+
+    auto& shared = sharedRoutes[slot];
+    shared.source = (int) newRoute.source;
+    shared.controllerNumber = jlimit (0, 127, newRoute.controllerNumber);
+    shared.destination = (int) newRoute.destination;
+    shared.amount = newRoute.amount;
+    routesChanged = true;
+}
+
+ModulationMatrix::Route ModulationMatrix::getRoute (int slot) const noexcept
+{
+    Route route;
+
+    if (isPositiveAndBelow (slot, numSlots))
+    {
+        auto& shared = sharedRoutes[slot];
+        route.source = (Source) jlimit ((int) Source::none, (int) Source::controller, shared.source.load());
+        route.controllerNumber = shared.controllerNumber;
+        route.destination = (Destination) jlimit ((int) Destination::cutoff, (int) Destination::level, shared.destination.load());
+        route.amount = shared.amount;
+    }
+
+    return route;
+}
+
+void ModulationMatrix::clearRoutes() noexcept
+{
+    for (int slot = 0; slot < numSlots; ++slot)
+        setRoute (slot, {});
+}
+
+bool ModulationMatrix::parseRoute (const String& text, Route& route)
+{
+    auto sourceName = text.upToFirstOccurrenceOf (":", false, false).trim().toLowerCase();
+    auto destinationName = text.fromFirstOccurrenceOf (":", false, false)
+                               .upToFirstOccurrenceOf ("=", false, false).trim().toLowerCase();
+    auto amountText = text.fromFirstOccurrenceOf ("=", false, false).trim();
+
+    if (! text.containsChar (':') || ! text.containsChar ('=')
+         || amountText.isEmpty() || ! amountText.containsOnly ("0123456789.-+"))
+        return false;
+
+    Route parsed;
+
+    if (! parseSource (sourceName, parsed) || ! parseDestination (destinationName, parsed))
+        return false;
+
+    parsed.amount = amountText.getFloatValue();
+    route = parsed;
+    return true;
+}
+
+//==============================================================================
+void ModulationMatrix::pullChanges() noexcept
+{
+    if (! routesChanged.exchange (false))
+        return;
+
+    numActiveRoutes = 0;
+
+    for (int slot = 0; slot < numSlots; ++slot)
+    {
+        auto route = getRoute (slot);
+
+        if (route.source != Source::none && route.amount != 0.0f)
+            activeRoutes[numActiveRoutes++] = route;
+    }
+}
+
+void ModulationMatrix::resetControllers() noexcept
+{
+    for (auto& state : channelStates)
+        state = {};
+}
+
+float ModulationMatrix::getSourceValue (const Route& route, const ChannelState& state, int midiNoteNumber) const noexcept
+{
+    switch (route.source)
+    {
+        case Source::pitchBend:         return (float) (state.pitchBend - 8192) / 8192.0f;
+        case Source::channelPressure:   return state.channelPressure / 127.0f;
+        case Source::polyAftertouch:    return state.polyAftertouch[midiNoteNumber & 127] / 127.0f;
+        case Source::controller:        return state.controllers[route.controllerNumber & 127] / 127.0f;
+        case Source::none:
+        default:                        return 0.0f;
+    }
+}
+
+ModulationMatrix::Offsets ModulationMatrix::evaluate (int midiChannel, int midiNoteNumber) const noexcept
+{
+    Offsets offsets;
+
+    if (numActiveRoutes == 0 || ! isPositiveAndNotGreaterThan (midiChannel, ParallelSynthesiser::numMidiChannels)
+         || midiChannel == 0)
+        return offsets;
+
+    auto& state = channelStates[midiChannel - 1];
+
+    for (int i = 0; i < numActiveRoutes; ++i)
+    {
+        auto& route = activeRoutes[i];
+        auto offset = getSourceValue (route, state, midiNoteNumber) * route.amount;
+
+        switch (route.destination)
+        {
+            case Destination::q:        offsets.qOctaves += offset; break;
+            case Destination::level:    offsets.levelDecibels += offset; break;
+            case Destination::cutoff:
+            default:                    offsets.cutoffSemitones += offset; break;
+        }
+    }
+
+    return offsets;
+}
+
+void ModulationMatrix::handleMidiEvent (const MidiMessage& message) noexcept
+{
+    auto channel = message.getChannel();
+
+    //system messages have no channel
+    if (! isPositiveAndNotGreaterThan (channel, ParallelSynthesiser::numMidiChannels) || channel == 0)
+        return;
+
+    auto& state = channelStates[channel - 1];
+
+    if (message.isPitchWheel())
+        state.pitchBend = message.getPitchWheelValue();
+    else if (message.isChannelPressure())
+        state.channelPressure = (uint8) message.getChannelPressureValue();
+    else if (message.isAftertouch())
+        state.polyAftertouch[message.getNoteNumber() & 127] = (uint8) message.getAfterTouchValue();
+    else if (message.isResetAllControllers())
+        state = {};
+    else if (message.isController())
+        state.controllers[message.getControllerNumber() & 127] = (uint8) message.getControllerValue();
+}
@@ -0,0 +1,121 @@
+/*
+    File: ModulationMatrix.h
+    Description: Routes the performance controllers to the voices: pitch bend, channel pressure,
+    polyphonic aftertouch and any CC can each move a voice's filter frequency, its Q and its
+    level, by an amount set per route.
+
+    The matrix watches every MIDI message the synth plays and remembers the last value of each
+    controller on each channel, so a note starts from wherever the wheel already is, and a voice
+    reads the state of its own channel and note. MPE needs nothing extra: its per-note pitch bend,
+    pressure and timbre (CC 74) arrive on each note's own member channel.
+
+    The voices evaluate the matrix once per render and move towards the result at their control
+    rate, interpolating the filter coefficients in between, so expressive playing never costs a
+    coefficient recompute per sample.
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParallelSynthesiser.h"
+
+//==============================================================================
+class ModulationMatrix   : public ParallelSynthesiser::MidiObserver
+{
+public:
+    enum class Source
+    {
+        none = 0,
+        pitchBend,          //-1 to 1, centred
+        channelPressure,    //0 to 1
+        polyAftertouch,     //0 to 1, per note
+        controller          //0 to 1, the route's CC number
+    };
+
+    enum class Destination
+    {
+        cutoff = 1,         //the filter's centre, amount in semitones
+        q,                  //the filter's Q, amount in octaves
+        level               //the voice's level, amount in decibels
+    };
+
+    //a route adds source value times amount to its destination; routes to the same destination sum
+    struct Route
+    {
+        Source source = Source::none;
+        int controllerNumber = 1;
+        Destination destination = Destination::cutoff;
+        float amount = 0.0f;
+    };
+
+    //how far the routes have moved a voice, in their destinations' units
+    struct Offsets
+    {
+        float cutoffSemitones = 0.0f, qOctaves = 0.0f, levelDecibels = 0.0f;
+    };
+
+    static constexpr int numSlots = 8;
+
+    ModulationMatrix();
+    ~ModulationMatrix();
+
+    //==============================================================================
+    //message thread. the audio thread picks the routes up at its next pullChanges()
+    void setRoute (int slot, const Route& newRoute) noexcept;
+    Route getRoute (int slot) const noexcept;
+    void clearRoutes() noexcept;
+
+    //parses "<source>:<destination>=<amount>", e.g. "bend:cutoff=2" or "cc1:q=3". the sources are
+    //bend, pressure, aftertouch and cc<n>; the destinations cutoff, q and level
+    static bool parseRoute (const String& text, Route& route);
+
+    //==============================================================================
+    //audio thread, once at the top of each block
+    void pullChanges() noexcept;
+
+    //audio thread: every channel's controllers back to rest, the wheels centred
+    void resetControllers() noexcept;
+
+    //true if any route can move anything, so voices can skip evaluating altogether
+    bool isActive() const noexcept                  { return numActiveRoutes > 0; }
+
+    //the sum of the active routes for a note on midiChannel (1 to 16). called by the voices as
+    //they render, on whichever thread renders them; the state only changes between renders
+    Offsets evaluate (int midiChannel, int midiNoteNumber) const noexcept;
+
+    //ParallelSynthesiser::MidiObserver
+    void handleMidiEvent (const MidiMessage& message) noexcept override;
+
+private:
+    //the message thread's edits stay off the lines the audio thread reads by a line of padding
+    //per route; alignas would do nothing here, as the matrix is allocated with new under C++14
+    static constexpr int cacheLineSize = 64;
+
+    struct SharedRoute
+    {
+        std::atomic<int> source { (int) Source::none }, controllerNumber { 1 }, destination { (int) Destination::cutoff };
+        std::atomic<float> amount { 0.0f };
+        char padding[cacheLineSize];
+    };
+
+    struct ChannelState
+    {
+        int pitchBend = 8192;
+        uint8 channelPressure = 0;
+        uint8 polyAftertouch[128] = {};
+        uint8 controllers[128] = {};
+    };
+
+    float getSourceValue (const Route& route, const ChannelState& state, int midiNoteNumber) const noexcept;
+
+    SharedRoute sharedRoutes[numSlots];
+    std::atomic<bool> routesChanged { true };
+
+    //the audio thread's copy, with the routes that do nothing left out
+    Route activeRoutes[numSlots];
+    int numActiveRoutes = 0;
+
+    ChannelState channelStates[ParallelSynthesiser::numMidiChannels];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ModulationMatrix)
+};
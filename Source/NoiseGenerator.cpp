@@ -0,0 +1,317 @@
+/*
+    File: NoiseGenerator.cpp
+    Description: xorshift32 lane kernels for NoiseGenerator. Each lane turns its top 23 state bits
+    into a float mantissa in [1, 2), so no integer-to-float conversion or division is needed. The
+    colouring filter runs over the finished white block.
+*/
+
+#include "NoiseGenerator.h"
+#include "CpuDispatch.h"
+
+#if JUCE_INTEL
+ #include <emmintrin.h>
+ #if defined (__AVX2__)
+  #include <immintrin.h>
+  #define NOISE_USE_AVX2 1
+ #else
+  #define NOISE_USE_SSE2 1
+  #if SYNTH_DISPATCH_AVX2
+   #include <immintrin.h>
+  #endif
+ #endif
+#elif JUCE_ARM && (defined (__ARM_NEON__) || defined (__ARM_NEON))
+ #include <arm_neon.h>
+ #define NOISE_USE_NEON 1
+#endif
+
+namespace
+{
+    //mantissa bits of 1.0f; or-ing 23 random bits into it gives a float in [1, 2)
+    constexpr uint32 floatOneBits = 0x3f800000u;
+
+    inline float nextSample (uint32& x) noexcept
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        
+        auto bits = (x >> 9) | floatOneBits;
+        float f;
+        std::memcpy (&f, &bits, sizeof (f));
+        return f - 1.5f;
+    }
+    
+   #if NOISE_USE_AVX2 || SYNTH_DISPATCH_AVX2
+    SYNTH_TARGET_AVX2 void processGroupsAVX2 (uint32* state, float* gains, float* dest,
+                                              int numGroups, float groupMultiplier) noexcept
+    {
+        auto s = _mm256_loadu_si256 ((const __m256i*) state);
+        auto g = _mm256_load_ps (gains);
+        const auto step = _mm256_set1_ps (groupMultiplier);
+        const auto one = _mm256_set1_epi32 ((int) floatOneBits);
+        const auto offset = _mm256_set1_ps (1.5f);
+        
+        for (; numGroups > 0; --numGroups, dest += NoiseGenerator::numLanes)
+        {
+            s = _mm256_xor_si256 (s, _mm256_slli_epi32 (s, 13));
+            s = _mm256_xor_si256 (s, _mm256_srli_epi32 (s, 17));
+            s = _mm256_xor_si256 (s, _mm256_slli_epi32 (s, 5));
+        
+            auto noise = _mm256_sub_ps (_mm256_castsi256_ps (_mm256_or_si256 (_mm256_srli_epi32 (s, 9), one)), offset);
+            _mm256_storeu_ps (dest, _mm256_mul_ps (noise, g));
+            g = _mm256_mul_ps (g, step);
+        }
+        
+        _mm256_storeu_si256 ((__m256i*) state, s);
+        _mm256_store_ps (gains, g);
+    }
+   #endif
+
+   #if NOISE_USE_SSE2
+    void processGroupsSSE2 (uint32* state, float* gains, float* dest,
+                            int numGroups, float groupMultiplier) noexcept
+    {
+        auto s0 = _mm_loadu_si128 ((const __m128i*) state);
+        auto s1 = _mm_loadu_si128 ((const __m128i*) (state + 4));
+        auto g0 = _mm_load_ps (gains);
+        auto g1 = _mm_load_ps (gains + 4);
+        const auto step = _mm_set1_ps (groupMultiplier);
+        const auto one = _mm_set1_epi32 ((int) floatOneBits);
+        const auto offset = _mm_set1_ps (1.5f);
+        
+        for (; numGroups > 0; --numGroups, dest += NoiseGenerator::numLanes)
+        {
+            s0 = _mm_xor_si128 (s0, _mm_slli_epi32 (s0, 13));
+            s1 = _mm_xor_si128 (s1, _mm_slli_epi32 (s1, 13));
+            s0 = _mm_xor_si128 (s0, _mm_srli_epi32 (s0, 17));
+            s1 = _mm_xor_si128 (s1, _mm_srli_epi32 (s1, 17));
+            s0 = _mm_xor_si128 (s0, _mm_slli_epi32 (s0, 5));
+            s1 = _mm_xor_si128 (s1, _mm_slli_epi32 (s1, 5));
+        
+            auto n0 = _mm_sub_ps (_mm_castsi128_ps (_mm_or_si128 (_mm_srli_epi32 (s0, 9), one)), offset);
+            auto n1 = _mm_sub_ps (_mm_castsi128_ps (_mm_or_si128 (_mm_srli_epi32 (s1, 9), one)), offset);
+            _mm_storeu_ps (dest,     _mm_mul_ps (n0, g0));
+            _mm_storeu_ps (dest + 4, _mm_mul_ps (n1, g1));
+            g0 = _mm_mul_ps (g0, step);
+            g1 = _mm_mul_ps (g1, step);
+        }
+        
+        _mm_storeu_si128 ((__m128i*) state, s0);
+        _mm_storeu_si128 ((__m128i*) (state + 4), s1);
+        _mm_store_ps (gains, g0);
+        _mm_store_ps (gains + 4, g1);
+    }
+   #endif
+
+    //Paul Kellet's refined pink filter: seven one-poles spread across the audio band, whose sum
+    //falls at 3 dB per octave to within 0.05 dB from 9 Hz up (at 44.1 kHz). blue is the
+    //difference of successive pink samples, which tilts the slope up by 6 dB per octave. the
+    //gains bring both back to white's RMS at 44.1 kHz. z holds the seven poles and the last
+    //pink sample
+    constexpr double designSampleRate = 44100.0;
+    constexpr float designPoles[]      = { 0.99886f,   0.99332f,   0.96900f,  0.86650f,   0.55000f,   -0.7616f };
+    constexpr float designInputGains[] = { 0.0555179f, 0.0750759f, 0.153852f, 0.3104856f, 0.5329522f, -0.016898f };
+    constexpr float pinkGain = 0.3296f;
+    constexpr float blueGain = 0.5512f;
+
+    template <bool isBlue, typename Filter>
+    void colourNoise (const Filter& filter, float* z, float* samples, int numSamples) noexcept
+    {
+        auto b0 = z[0], b1 = z[1], b2 = z[2], b3 = z[3], b4 = z[4], b5 = z[5], b6 = z[6];
+        auto lastPink = z[7];
+        auto& p = filter.poles;
+        auto& g = filter.inputGains;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto white = samples[i];
+
+            b0 = p[0] * b0 + white * g[0];
+            b1 = p[1] * b1 + white * g[1];
+            b2 = p[2] * b2 + white * g[2];
+            b3 = p[3] * b3 + white * g[3];
+            b4 = p[4] * b4 + white * g[4];
+            b5 = p[5] * b5 + white * g[5];
+
+            auto pink = b0 + b1 + b2 + b3 + b4 + b5 + b6 + white * 0.5362f;
+            b6 = white * 0.115926f;
+
+            samples[i] = isBlue ? (pink - lastPink) * filter.blueGain : pink * pinkGain;
+            lastPink = pink;
+        }
+
+        z[0] = b0; z[1] = b1; z[2] = b2; z[3] = b3; z[4] = b4; z[5] = b5; z[6] = b6;
+        z[7] = lastPink;
+    }
+}
+
+//==============================================================================
+NoiseGenerator::NoiseGenerator()
+{
+    setSeed (0);
+    setSampleRate (designSampleRate);
+}
+
+void NoiseGenerator::setSampleRate (double sampleRate) noexcept
+{
+    auto ratio = designSampleRate / jmax (1.0, sampleRate);
+
+    //each low-pass pole keeps its corner frequency and its gain below it. the last pole sits
+    //near Nyquist and only shapes the very top, so it stays as it is
+    for (int i = 0; i < numColourPoles; ++i)
+    {
+        auto pole = (double) designPoles[i];
+
+        if (ratio == 1.0 || pole <= 0.0)
+        {
+            colourFilter.poles[i] = designPoles[i];
+            colourFilter.inputGains[i] = designInputGains[i];
+        }
+        else
+        {
+            auto newPole = std::pow (pole, ratio);
+            colourFilter.poles[i] = (float) newPole;
+            colourFilter.inputGains[i] = (float) (designInputGains[i] * (1.0 - newPole) / (1.0 - pole));
+        }
+    }
+
+    //a difference of successive samples is 1 / ratio times smaller at a given frequency the
+    //faster it runs
+    colourFilter.blueGain = (float) (blueGain / ratio);
+}
+
+void NoiseGenerator::setSeed (uint32 seed, uint32 stream) noexcept
+{
+    //each lane's state is splitmix64 run on its own counter, keyed by the seed and stream, so
+    //neighbouring seeds or streams still give unrelated, non-zero lane states
+    auto key = ((uint64) seed << 32) | stream;
+
+    for (int i = 0; i < numLanes; ++i)
+    {
+        auto z = key + 0x9e3779b97f4a7c15ull * (uint64) (i + 1);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        z ^= z >> 31;
+
+        auto laneState = (uint32) (z ^ (z >> 32));
+        state[i] = laneState != 0 ? laneState : 0x6d2b79f5u;
+    }
+
+    std::fill (colourState, colourState + numColourStates, 0.0f);
+}
+
+void NoiseGenerator::setColour (Colour newColour) noexcept
+{
+    if (newColour == colour)
+        return;
+
+    colour = newColour;
+    std::fill (colourState, colourState + numColourStates, 0.0f);
+}
+
+void NoiseGenerator::process (float* dest, int numSamples, float startGain, float gainMultiplier) noexcept
+{
+    if (colour == Colour::white)
+    {
+        processWhite (dest, numSamples, startGain, gainMultiplier);
+        return;
+    }
+
+    //the filter runs on unit-gain noise, so a new gain never has to wait for its state to catch up
+    processWhite (dest, numSamples, 1.0f, 1.0f);
+
+    if (colour == Colour::blue)
+        colourNoise<true> (colourFilter, colourState, dest, numSamples);
+    else
+        colourNoise<false> (colourFilter, colourState, dest, numSamples);
+
+    if (gainMultiplier == 1.0f)
+    {
+        FloatVectorOperations::multiply (dest, startGain, numSamples);
+    }
+    else
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            dest[i] *= startGain;
+            startGain *= gainMultiplier;
+        }
+    }
+}
+
+void NoiseGenerator::processWhite (float* dest, int numSamples, float startGain, float gainMultiplier) noexcept
+{
+    //lane gains for the first group of numLanes samples; the 0.5 maps [-0.5, 0.5) onto the
+    //existing +-0.25 noise range
+    alignas (32) float gains[numLanes];
+    auto gain = startGain * 0.5f;
+    auto groupMultiplier = 1.0f;
+    
+    for (int i = 0; i < numLanes; ++i)
+    {
+        gains[i] = gain;
+        gain *= gainMultiplier;
+        groupMultiplier *= gainMultiplier;
+    }
+    
+    auto numGroups = numSamples / numLanes;
+    
+   #if NOISE_USE_AVX2
+    processGroupsAVX2 (state, gains, dest, numGroups, groupMultiplier);
+    dest += numGroups * numLanes;
+   #elif NOISE_USE_SSE2
+    #if SYNTH_DISPATCH_AVX2
+    if (CpuDispatch::hasAVX2())
+        processGroupsAVX2 (state, gains, dest, numGroups, groupMultiplier);
+    else
+    #endif
+        processGroupsSSE2 (state, gains, dest, numGroups, groupMultiplier);
+    
+    dest += numGroups * numLanes;
+   #elif NOISE_USE_NEON
+    {
+        auto s0 = vld1q_u32 (state);
+        auto s1 = vld1q_u32 (state + 4);
+        auto g0 = vld1q_f32 (gains);
+        auto g1 = vld1q_f32 (gains + 4);
+        const auto step = vdupq_n_f32 (groupMultiplier);
+        const auto one = vdupq_n_u32 (floatOneBits);
+        const auto offset = vdupq_n_f32 (1.5f);
+        
+        for (; numGroups > 0; --numGroups, dest += numLanes)
+        {
+            s0 = veorq_u32 (s0, vshlq_n_u32 (s0, 13));
+            s1 = veorq_u32 (s1, vshlq_n_u32 (s1, 13));
+            s0 = veorq_u32 (s0, vshrq_n_u32 (s0, 17));
+            s1 = veorq_u32 (s1, vshrq_n_u32 (s1, 17));
+            s0 = veorq_u32 (s0, vshlq_n_u32 (s0, 5));
+            s1 = veorq_u32 (s1, vshlq_n_u32 (s1, 5));
+            
+            auto n0 = vsubq_f32 (vreinterpretq_f32_u32 (vorrq_u32 (vshrq_n_u32 (s0, 9), one)), offset);
+            auto n1 = vsubq_f32 (vreinterpretq_f32_u32 (vorrq_u32 (vshrq_n_u32 (s1, 9), one)), offset);
+            vst1q_f32 (dest,     vmulq_f32 (n0, g0));
+            vst1q_f32 (dest + 4, vmulq_f32 (n1, g1));
+            g0 = vmulq_f32 (g0, step);
+            g1 = vmulq_f32 (g1, step);
+        }
+        
+        vst1q_u32 (state, s0);
+        vst1q_u32 (state + 4, s1);
+        vst1q_f32 (gains, g0);
+        vst1q_f32 (gains + 4, g1);
+    }
+   #else
+    for (; numGroups > 0; --numGroups, dest += numLanes)
+    {
+        for (int i = 0; i < numLanes; ++i)
+        {
+            dest[i] = nextSample (state[i]) * gains[i];
+            gains[i] *= groupMultiplier;
+        }
+    }
+   #endif
+    
+    //the last partial group always runs scalar, so every path yields the same sequence
+    for (int i = 0; i < numSamples % numLanes; ++i)
+        dest[i] = nextSample (state[i]) * gains[i];
+}
@@ -0,0 +1,71 @@
+/*
+    File: NoiseGenerator.h
+    Description: Block-based noise source for the voices. Eight independent xorshift32 lanes are
+    stepped together so the whole generator maps onto SSE2/AVX2/NEON registers, with a scalar
+    fallback that produces exactly the same sequence. Pink and blue noise are that white noise
+    through a colouring filter tuned to the sample rate, so the slope sits at the same
+    frequencies whatever rate the voices run at.
+
+    The lanes are seeded from a (seed, stream) pair by hashing, so generators can split one seed
+    into as many independent streams as they like without sharing any state: the same pair always
+    gives the same samples, on any machine and whichever thread runs it.
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class NoiseGenerator
+{
+public:
+    static constexpr int numLanes = 8;
+
+    //the spectrum: flat, falling 3 dB per octave or rising 3 dB per octave, all at the same RMS
+    enum class Colour
+    {
+        white = 1,
+        pink,
+        blue
+    };
+
+    NoiseGenerator();
+
+    //restarts the generator on the given stream of the seed, colour filter included
+    void setSeed (uint32 seed, uint32 stream = 0) noexcept;
+
+    //retunes the colour filter; the white noise doesn't depend on the rate
+    void setSampleRate (double sampleRate) noexcept;
+
+    //clears the colour filter if the colour changes
+    void setColour (Colour newColour) noexcept;
+    Colour getColour() const noexcept       { return colour; }
+
+    //fills dest with noise (white in [-0.25, 0.25), pink and blue at the same RMS) multiplied by
+    //a geometric gain ramp: the first sample gets startGain and each following sample the
+    //previous gain * gainMultiplier. pass gainMultiplier = 1 for a constant gain
+    void process (float* dest, int numSamples, float startGain, float gainMultiplier) noexcept;
+
+private:
+    static constexpr int numColourStates = 8;
+    static constexpr int numColourPoles = 6;
+
+    //the pink filter's one-poles, and blue's gain on top of the difference it takes
+    struct ColourFilter
+    {
+        float poles[numColourPoles];
+        float inputGains[numColourPoles];
+        float blueGain;
+    };
+
+    void processWhite (float* dest, int numSamples, float startGain, float gainMultiplier) noexcept;
+
+    //the voices that own a generator are created with new, which before C++17 doesn't honour
+    //over-alignment, so the kernels load and store the lanes unaligned
+    uint32 state[numLanes];
+    Colour colour = Colour::white;
+    ColourFilter colourFilter;
+    float colourState[numColourStates] = {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NoiseGenerator)
+};
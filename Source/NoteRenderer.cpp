@@ -0,0 +1,117 @@
+/*
+    File: NoteRenderer.cpp
+    Description: See NoteRenderer.h
+*/
+
+#include "NoteRenderer.h"
+
+static_assert (RenderCache::maxChannels == ParallelSynthesiser::VoiceOutput::maxChannels,
+               "a segment holds every channel a voice renders");
+
+NoteRenderer::NoteRenderer()
+{
+    voice = new SynthVoice();
+    voice->setParameters (parameters);
+    voice->setVelocityCurve (&velocityCurve);
+    synth.addVoice (voice);
+    synth.addSound (new SynthSound());
+}
+
+NoteRenderer::~NoteRenderer() {}
+
+void NoteRenderer::prepare (double sampleRate, int voiceRate)
+{
+    if (sampleRate == preparedSampleRate && voiceRate == preparedVoiceRate)
+        return;
+
+    preparedSampleRate = sampleRate;
+    preparedVoiceRate = voiceRate;
+
+    //the voice runs at voiceRate times the key's rate, as it would in SynthAudioSource
+    auto voiceSampleRate = sampleRate * voiceRate;
+
+    synth.setCurrentPlaybackSampleRate (voiceSampleRate);
+    voice->prepareToPlay (blockSize * voiceRate, CHANNELS, voiceSampleRate);
+    voice->setOversamplingFactor (voiceRate);
+    voiceBuffer.setSize (CHANNELS, blockSize * voiceRate);
+    decimator.prepare (voiceRate, blockSize, CHANNELS);
+}
+
+std::shared_ptr<const RenderCache::Segment> NoteRenderer::render (const RenderCache::NoteKey& key)
+{
+    jassert (key.sampleRate > 0.0);
+    jassert (key.voiceRate == 1 || key.voiceRate == 2 || key.voiceRate == Decimator::maxFactor);
+
+    prepare (key.sampleRate, key.voiceRate);
+
+    parameters.setValue (SynthParameters::q, key.q);
+    parameters.setValue (SynthParameters::spread, key.spread);
+    parameters.setValue (SynthParameters::filterType, (float) key.topology);
+    parameters.setValue (SynthParameters::noiseColour, (float) key.noiseColour);
+    parameters.setValue (SynthParameters::velocityCurve, (float) key.velocityCurve);
+    parameters.setValue (SynthParameters::velocityQ, key.velocityQ);
+    parameters.prepare (key.sampleRate * key.voiceRate);
+
+    EnvelopeGenerator::Parameters envelopeParameters;
+    envelopeParameters.attack = key.attack;
+    envelopeParameters.decay = key.decay;
+    envelopeParameters.sustain = key.sustain;
+    envelopeParameters.release = key.release;
+
+    voice->setEnvelopeParameters (envelopeParameters);
+    voice->setFilterTopology ((VoiceFilter::Topology) key.topology);
+    voice->setPanLaw ((SynthVoice::PanLaw) key.panLaw);
+    voice->setStereoNoise (key.stereoNoise != 0);
+    voice->setNoiseColour ((NoiseGenerator::Colour) key.noiseColour);
+
+    //the key picks the stream, so the note is the same wherever and whenever it is rendered
+    voice->setNoiseSeed (key.noiseSeed, (int) (key.getHash() >> 33));
+
+    synth.allNotesOff (0, false);
+    decimator.reset();
+    synth.noteOn (1, key.midiNoteNumber, key.velocity);
+
+    //the pan is set when the note starts
+    ParallelSynthesiser::VoiceOutput voiceOutput;
+    voice->getOutput (voiceOutput);
+
+    auto numChannels = jlimit (1, RenderCache::maxChannels, voiceOutput.numChannels);
+    auto expectedLength = key.lengthInSamples + (int64) (key.release * key.sampleRate) + blockSize;
+    AudioBuffer<float> samples (numChannels, (int) jmin (expectedLength, (int64) std::numeric_limits<int>::max() / 2));
+    int numWritten = 0;
+
+    //a note whose sustain is zero can stop before its note-off
+    for (auto remaining = key.lengthInSamples; remaining > 0 && voice->isVoiceActive();)
+    {
+        auto numThisTime = (int) jmin ((int64) blockSize, remaining);
+        renderBlock (samples, numWritten, numChannels, numThisTime);
+        remaining -= numThisTime;
+    }
+
+    synth.noteOff (1, key.midiNoteNumber, 0.0f, true);
+
+    while (voice->isVoiceActive())
+        renderBlock (samples, numWritten, numChannels, blockSize);
+
+    //the last of the tail is still in the decimator's filters, which are as long as twice its delay
+    if (key.voiceRate > 1)
+        renderBlock (samples, numWritten, numChannels, (int) std::ceil (2.0f * decimator.getLatencyInSamples()) + 1);
+
+    samples.setSize (numChannels, numWritten, true);
+
+    return std::make_shared<const RenderCache::Segment> (std::move (samples), voiceOutput.gains);
+}
+
+void NoteRenderer::renderBlock (AudioBuffer<float>& output, int& numWritten, int numChannels, int numSamples)
+{
+    if (numWritten + numSamples > output.getNumSamples())
+        output.setSize (numChannels, jmax (2 * output.getNumSamples(), numWritten + numSamples), true, true, true);
+
+    auto numVoiceSamples = numSamples * preparedVoiceRate;
+
+    //the voice adds itself in
+    voiceBuffer.clear (0, numVoiceSamples);
+    synth.renderNextBlock (voiceBuffer, MidiBuffer(), 0, numVoiceSamples);
+    decimator.process (voiceBuffer, output, numWritten, numSamples);
+    numWritten += numSamples;
+}
@@ -0,0 +1,45 @@
+/*
+    File: NoteRenderer.h
+    Description: Renders one note in isolation for the RenderCache: a single SynthVoice, set up
+    entirely from a NoteKey, played from note-on through its release until it has rung out, and
+    brought back to the key's sample rate when it runs oversampled.
+
+    Every key gets its own noise stream, derived from the key itself, so the same key always
+    renders the same samples and two notes that differ in anything never share noise.
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Decimator.h"
+#include "RenderCache.h"
+#include "SynthEngine.h"
+
+//==============================================================================
+class NoteRenderer
+{
+public:
+    NoteRenderer();
+    ~NoteRenderer();
+
+    //allocates the segment and, on a new sample rate or voice rate, re-prepares the voice; for
+    //offline use only
+    std::shared_ptr<const RenderCache::Segment> render (const RenderCache::NoteKey& key);
+
+private:
+    static constexpr int blockSize = 512;   //at the key's sample rate
+
+    void prepare (double sampleRate, int voiceRate);
+    void renderBlock (AudioBuffer<float>& output, int& numWritten, int numChannels, int numSamples);
+
+    SynthParameters parameters;
+    VelocityCurve velocityCurve;
+    Synthesiser synth;
+    SynthVoice* voice = nullptr;            //owned by synth
+    Decimator decimator;
+    AudioBuffer<float> voiceBuffer;
+    double preparedSampleRate = 0.0;
+    int preparedVoiceRate = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NoteRenderer)
+};
@@ -0,0 +1,233 @@
+/*
+    File: OutputStage.cpp
+    Description: Gain-and-clip kernels for OutputStage. The clipper shapes are written once against
+    a tiny set of vector operations, so the SSE2, NEON and scalar paths share the same maths.
+*/
+
+#include "OutputStage.h"
+
+#if JUCE_INTEL
+ #include <emmintrin.h>
+ #define OUTPUT_USE_SSE2 1
+#elif JUCE_ARM && (defined (__ARM_NEON__) || defined (__ARM_NEON))
+ #include <arm_neon.h>
+ #define OUTPUT_USE_NEON 1
+#endif
+
+namespace
+{
+    struct ScalarOps
+    {
+        using Vector = float;
+        static constexpr int width = 1;
+
+        static Vector load (const float* src) noexcept                  { return *src; }
+        static void store (float* dest, Vector v) noexcept              { *dest = v; }
+        static Vector broadcast (float v) noexcept                      { return v; }
+        static Vector ramp (float start, float step) noexcept           { ignoreUnused (step); return start; }
+        static Vector add (Vector a, Vector b) noexcept                 { return a + b; }
+        static Vector mul (Vector a, Vector b) noexcept                 { return a * b; }
+        static Vector div (Vector a, Vector b) noexcept                 { return a / b; }
+        static Vector min (Vector a, Vector b) noexcept                 { return b < a ? b : a; }
+        static Vector max (Vector a, Vector b) noexcept                 { return a < b ? b : a; }
+    };
+
+   #if OUTPUT_USE_SSE2
+    struct VectorOps
+    {
+        using Vector = __m128;
+        static constexpr int width = 4;
+
+        static Vector load (const float* src) noexcept                  { return _mm_loadu_ps (src); }
+        static void store (float* dest, Vector v) noexcept              { _mm_storeu_ps (dest, v); }
+        static Vector broadcast (float v) noexcept                      { return _mm_set1_ps (v); }
+        static Vector ramp (float start, float step) noexcept           { return _mm_setr_ps (start, start + step, start + 2.0f * step, start + 3.0f * step); }
+        static Vector add (Vector a, Vector b) noexcept                 { return _mm_add_ps (a, b); }
+        static Vector mul (Vector a, Vector b) noexcept                 { return _mm_mul_ps (a, b); }
+        static Vector div (Vector a, Vector b) noexcept                 { return _mm_div_ps (a, b); }
+        static Vector min (Vector a, Vector b) noexcept                 { return _mm_min_ps (a, b); }
+        static Vector max (Vector a, Vector b) noexcept                 { return _mm_max_ps (a, b); }
+    };
+   #elif OUTPUT_USE_NEON
+    struct VectorOps
+    {
+        using Vector = float32x4_t;
+        static constexpr int width = 4;
+
+        static Vector load (const float* src) noexcept                  { return vld1q_f32 (src); }
+        static void store (float* dest, Vector v) noexcept              { vst1q_f32 (dest, v); }
+        static Vector broadcast (float v) noexcept                      { return vdupq_n_f32 (v); }
+        static Vector add (Vector a, Vector b) noexcept                 { return vaddq_f32 (a, b); }
+        static Vector mul (Vector a, Vector b) noexcept                 { return vmulq_f32 (a, b); }
+        static Vector min (Vector a, Vector b) noexcept                 { return vminq_f32 (a, b); }
+        static Vector max (Vector a, Vector b) noexcept                 { return vmaxq_f32 (a, b); }
+
+        static Vector ramp (float start, float step) noexcept
+        {
+            const float values[] = { start, start + step, start + 2.0f * step, start + 3.0f * step };
+            return vld1q_f32 (values);
+        }
+
+        static Vector div (Vector a, Vector b) noexcept
+        {
+          #if defined (__aarch64__)
+            return vdivq_f32 (a, b);
+          #else
+            //armv7 has no divide; two Newton steps bring the estimate to full precision
+            auto r = vrecpeq_f32 (b);
+            r = vmulq_f32 (vrecpsq_f32 (b, r), r);
+            r = vmulq_f32 (vrecpsq_f32 (b, r), r);
+            return vmulq_f32 (a, r);
+          #endif
+        }
+    };
+   #endif
+
+    //==============================================================================
+    template <typename Ops, OutputStage::ClipMode mode>
+    inline typename Ops::Vector shape (typename Ops::Vector x) noexcept
+    {
+        const auto one = Ops::broadcast (1.0f);
+        const auto minusOne = Ops::broadcast (-1.0f);
+
+        switch (mode)
+        {
+            case OutputStage::ClipMode::tanh:
+            {
+                //the 7/6 Pade approximant juce::dsp::FastMathApproximations uses, valid to +-5
+                x = Ops::min (Ops::max (x, Ops::broadcast (-5.0f)), Ops::broadcast (5.0f));
+                auto x2 = Ops::mul (x, x);
+
+                auto numerator = Ops::add (Ops::broadcast (378.0f), x2);
+                numerator = Ops::add (Ops::broadcast (17325.0f), Ops::mul (x2, numerator));
+                numerator = Ops::mul (x, Ops::add (Ops::broadcast (135135.0f), Ops::mul (x2, numerator)));
+
+                auto denominator = Ops::add (Ops::broadcast (3150.0f), Ops::mul (Ops::broadcast (28.0f), x2));
+                denominator = Ops::add (Ops::broadcast (62370.0f), Ops::mul (x2, denominator));
+                denominator = Ops::add (Ops::broadcast (135135.0f), Ops::mul (x2, denominator));
+
+                //the approximant creeps just past 1 near the edge of its range
+                return Ops::min (Ops::max (Ops::div (numerator, denominator), minusOne), one);
+            }
+
+            case OutputStage::ClipMode::cubic:
+            {
+                x = Ops::min (Ops::max (x, minusOne), one);
+                auto x3 = Ops::mul (Ops::mul (x, x), x);
+                return Ops::add (Ops::mul (Ops::broadcast (1.5f), x), Ops::mul (Ops::broadcast (-0.5f), x3));
+            }
+
+            case OutputStage::ClipMode::hard:
+            default:
+                return Ops::min (Ops::max (x, minusOne), one);
+        }
+    }
+
+    template <typename Ops, OutputStage::ClipMode mode>
+    inline int applyGainAndClip (float* samples, int numSamples, float gain, float gainStep) noexcept
+    {
+        auto numVectors = numSamples / Ops::width;
+        auto gains = Ops::ramp (gain, gainStep);
+        const auto vectorStep = Ops::broadcast (gainStep * (float) Ops::width);
+
+        for (int i = 0; i < numVectors; ++i, samples += Ops::width)
+        {
+            Ops::store (samples, shape<Ops, mode> (Ops::mul (Ops::load (samples), gains)));
+            gains = Ops::add (gains, vectorStep);
+        }
+
+        return numVectors * Ops::width;
+    }
+
+    template <OutputStage::ClipMode mode>
+    void applyGainAndClip (float* samples, int numSamples, float startGain, float endGain) noexcept
+    {
+        auto gainStep = (endGain - startGain) / (float) numSamples;
+        int done = 0;
+
+       #if OUTPUT_USE_SSE2 || OUTPUT_USE_NEON
+        done = applyGainAndClip<VectorOps, mode> (samples, numSamples, startGain, gainStep);
+       #endif
+
+        applyGainAndClip<ScalarOps, mode> (samples + done, numSamples - done,
+                                           startGain + gainStep * (float) done, gainStep);
+    }
+
+    void applyGainAndClip (OutputStage::ClipMode mode, float* samples, int numSamples,
+                           float startGain, float endGain) noexcept
+    {
+        switch (mode)
+        {
+            case OutputStage::ClipMode::tanh:   applyGainAndClip<OutputStage::ClipMode::tanh>  (samples, numSamples, startGain, endGain); break;
+            case OutputStage::ClipMode::cubic:  applyGainAndClip<OutputStage::ClipMode::cubic> (samples, numSamples, startGain, endGain); break;
+            case OutputStage::ClipMode::hard:
+            default:                            applyGainAndClip<OutputStage::ClipMode::hard>  (samples, numSamples, startGain, endGain); break;
+        }
+    }
+}
+
+//==============================================================================
+OutputStage::OutputStage() {}
+OutputStage::~OutputStage() {}
+
+void OutputStage::prepare (int maximumBlockSize, int numChannels)
+{
+    preparedBlockSize = maximumBlockSize;
+    preparedChannels = numChannels;
+
+    //one 2x stage of polyphase half-band IIRs
+    oversampling.reset (new dsp::Oversampling<float> ((size_t) numChannels, 1,
+                                                      dsp::Oversampling<float>::filterHalfBandPolyphaseIIR));
+    oversampling->initProcessing ((size_t) maximumBlockSize);
+    wasOversampled = false;
+}
+
+float OutputStage::getLatencyInSamples() noexcept
+{
+    return oversampled && oversampling != nullptr ? oversampling->getLatencyInSamples() : 0.0f;
+}
+
+void OutputStage::process (AudioBuffer<float>& buffer, int startSample, int numSamples,
+                           float startGain, float endGain) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    //the oversampling filters' tails decay into denormals once the input goes quiet
+    const ScopedNoDenormals noDenormals;
+
+    auto mode = getClipMode();
+    auto numChannels = buffer.getNumChannels();
+    auto useOversampling = oversampled && oversampling != nullptr
+                            && numChannels <= preparedChannels && numSamples <= preparedBlockSize;
+
+    if (useOversampling)
+    {
+        //stale filter state from the last time it was on would click
+        if (! wasOversampled)
+            oversampling->reset();
+
+        auto block = dsp::AudioBlock<float> (buffer).getSubBlock ((size_t) startSample, (size_t) numSamples);
+        auto upsampled = oversampling->processSamplesUp (block);
+
+        for (size_t channel = 0; channel < upsampled.getNumChannels(); ++channel)
+            applyGainAndClip (mode, upsampled.getChannelPointer (channel), (int) upsampled.getNumSamples(),
+                              startGain, endGain);
+
+        oversampling->processSamplesDown (block);
+
+        //the decimation filter can ring a touch past full scale
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* samples = buffer.getWritePointer (channel, startSample);
+            FloatVectorOperations::clip (samples, samples, -1.0f, 1.0f, numSamples);
+        }
+    }
+    else
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            applyGainAndClip (mode, buffer.getWritePointer (channel, startSample), numSamples, startGain, endGain);
+    }
+
+    wasOversampled = useOversampling;
+}
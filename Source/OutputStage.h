@@ -0,0 +1,53 @@
+/*
+    File: OutputStage.h
+    Description: The last stage before the device: applies the block's output gain (master volume
+    times the voices' Q makeup gain, ramped linearly across the block) and a hard or soft clipper
+    in a single SIMD pass over each channel. The soft clippers can optionally run at twice the
+    sample rate to keep their harmonics from aliasing.
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class OutputStage
+{
+public:
+    enum class ClipMode
+    {
+        hard = 1,   //clamps to +-1
+        tanh,       //rational tanh approximation
+        cubic       //1.5x - 0.5x^3, flat beyond +-1
+    };
+
+    OutputStage();
+    ~OutputStage();
+
+    //sizes the oversampler; the only place the stage allocates. never from the audio thread
+    void prepare (int maximumBlockSize, int numChannels);
+
+    //both can be changed from any thread; the audio thread picks them up at the next block
+    void setClipMode (ClipMode newMode) noexcept            { clipMode = (int) newMode; }
+    ClipMode getClipMode() const noexcept                   { return (ClipMode) clipMode.load(); }
+    void setOversampled (bool shouldOversample) noexcept    { oversampled = shouldOversample; }
+    bool isOversampled() const noexcept                     { return oversampled; }
+
+    //extra delay introduced by the oversampling filters, in samples at the device rate
+    float getLatencyInSamples() noexcept;
+
+    //applies a gain ramping from startGain to endGain across the range and then the clipper,
+    //in place
+    void process (AudioBuffer<float>& buffer, int startSample, int numSamples,
+                  float startGain, float endGain) noexcept;
+
+private:
+    std::unique_ptr<dsp::Oversampling<float>> oversampling;
+    int preparedBlockSize = 0, preparedChannels = 0;
+    bool wasOversampled = false;
+
+    std::atomic<int> clipMode { (int) ClipMode::hard };
+    std::atomic<bool> oversampled { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OutputStage)
+};
@@ -0,0 +1,302 @@
+/*
+    File: ParallelSynthesiser.cpp
+    Description: See ParallelSynthesiser.h
+*/
+
+#include "ParallelSynthesiser.h"
+#include "AllocationGuard.h"
+
+ParallelSynthesiser::ParallelSynthesiser()
+{
+    for (auto& limit : channelVoiceLimits)
+        limit = std::numeric_limits<int>::max();
+}
+
+ParallelSynthesiser::~ParallelSynthesiser()
+{
+    //the pool owns the voices, so the base class must not delete them
+    const ScopedLock sl (lock);
+    voices.clear (false);
+}
+
+void ParallelSynthesiser::setVoicePool (std::shared_ptr<void> newPool, const Array<SynthesiserVoice*>& newVoices,
+                                        LevelFunction newLevelFunction, OutputFunction newOutputFunction)
+{
+    auto numVoices = newVoices.size();
+
+    //everything is allocated before taking the lock and the old pool is freed after releasing it
+    OwnedArray<AudioBuffer<float>> newBuffers;
+    HeapBlock<int> newActiveVoices ((size_t) numVoices), newFreeVoices ((size_t) numVoices);
+    HeapBlock<uint64> newTaskCycles ((size_t) numVoices, true);
+    HeapBlock<VoiceOutput> newVoiceOutputs ((size_t) numVoices);
+
+    for (int i = 0; i < numVoices; ++i)
+    {
+        newBuffers.add (new AudioBuffer<float> (jmax (1, preparedChannels), jmax (1, preparedBlockSize)));
+
+        //popped from the back, so the lowest voices get used first
+        newFreeVoices[i] = numVoices - 1 - i;
+    }
+
+    for (auto* voice : newVoices)
+        voice->setCurrentPlaybackSampleRate (getSampleRate());
+
+    {
+        const ScopedLock sl (lock);
+
+        voices.clear (false);
+
+        for (auto* voice : newVoices)
+            voices.add (voice);
+
+        std::swap (voicePool, newPool);
+        voiceBuffers.swapWith (newBuffers);
+        activeVoices.swapWith (newActiveVoices);
+        freeVoices.swapWith (newFreeVoices);
+        taskCycles.swapWith (newTaskCycles);
+        voiceOutputs.swapWith (newVoiceOutputs);
+
+        levelFunction = newLevelFunction;
+        outputFunction = newOutputFunction;
+        numActiveVoices = 0;
+        numFreeVoices = numVoices;
+    }
+}
+
+void ParallelSynthesiser::prepare (int maximumBlockSize, int numChannels)
+{
+    const ScopedLock sl (lock);
+
+    preparedBlockSize = maximumBlockSize;
+    preparedChannels = numChannels;
+
+    for (auto* buffer : voiceBuffers)
+        buffer->setSize (numChannels, maximumBlockSize, false, false, true);
+}
+
+//==============================================================================
+void ParallelSynthesiser::setChannelVoiceLimit (int midiChannel, int maxVoices) noexcept
+{
+    jassert (midiChannel > 0 && midiChannel <= numMidiChannels);
+
+    if (midiChannel > 0 && midiChannel <= numMidiChannels)
+        channelVoiceLimits[midiChannel - 1] = jmax (0, maxVoices);
+}
+
+int ParallelSynthesiser::getChannelVoiceLimit (int midiChannel) const noexcept
+{
+    return midiChannel > 0 && midiChannel <= numMidiChannels ? channelVoiceLimits[midiChannel - 1].load()
+                                                             : std::numeric_limits<int>::max();
+}
+
+int ParallelSynthesiser::countVoicesOnChannel (int midiChannel) const noexcept
+{
+    int count = 0;
+
+    for (int i = 0; i < numActiveVoices; ++i)
+    {
+        auto* voice = voices.getUnchecked (activeVoices[i]);
+
+        if (voice->isVoiceActive() && voice->isPlayingChannel (midiChannel))
+            ++count;
+    }
+
+    return count;
+}
+
+//==============================================================================
+SynthesiserVoice* ParallelSynthesiser::findFreeVoice (SynthesiserSound* soundToPlay, int midiChannel,
+                                                      int midiNoteNumber, bool stealIfNoneAvailable) const
+{
+    const ScopedLock sl (lock);
+
+    //a channel at its limit only ever takes over one of its own voices
+    auto limit = getChannelVoiceLimit (midiChannel);
+
+    if (limit < voices.size() && countVoicesOnChannel (midiChannel) >= limit)
+        return limit > 0 && stealIfNoneAvailable ? findVoiceToStealOnChannel (soundToPlay, midiChannel) : nullptr;
+
+    if (numFreeVoices > 0)
+    {
+        auto voiceIndex = freeVoices[numFreeVoices - 1];
+        auto* voice = voices.getUnchecked (voiceIndex);
+
+        if (voice->canPlaySound (soundToPlay))
+        {
+            --numFreeVoices;
+            activeVoices[numActiveVoices++] = voiceIndex;
+            return voice;
+        }
+    }
+
+    //a voice that finished since the last block is still listed as active; reuse it in place
+    for (int i = 0; i < numActiveVoices; ++i)
+    {
+        auto* voice = voices.getUnchecked (activeVoices[i]);
+
+        if (! voice->isVoiceActive() && voice->canPlaySound (soundToPlay))
+            return voice;
+    }
+
+    if (stealIfNoneAvailable)
+        return findVoiceToSteal (soundToPlay, midiChannel, midiNoteNumber);
+
+    return nullptr;
+}
+
+SynthesiserVoice* ParallelSynthesiser::findVoiceToSteal (SynthesiserSound* soundToPlay, int, int) const
+{
+    return findVoiceToStealOnChannel (soundToPlay, 0);
+}
+
+SynthesiserVoice* ParallelSynthesiser::findVoiceToStealOnChannel (SynthesiserSound* soundToPlay, int midiChannel) const
+{
+    const ScopedLock sl (lock);
+
+    SynthesiserVoice* voiceToSteal = nullptr;
+
+    for (int i = 0; i < numActiveVoices; ++i)
+    {
+        auto* voice = voices.getUnchecked (activeVoices[i]);
+
+        if (voice->canPlaySound (soundToPlay)
+             && (midiChannel == 0 || voice->isPlayingChannel (midiChannel))
+             && (voiceToSteal == nullptr || shouldStealInsteadOf (voice, voiceToSteal)))
+            voiceToSteal = voice;
+    }
+
+    return voiceToSteal;
+}
+
+bool ParallelSynthesiser::shouldStealInsteadOf (SynthesiserVoice* candidate, SynthesiserVoice* current) const noexcept
+{
+    switch (getStealingPolicy())
+    {
+        case StealingPolicy::quietest:
+        {
+            auto candidateLevel = levelFunction (*candidate);
+            auto currentLevel = levelFunction (*current);
+
+            if (candidateLevel != currentLevel)
+                return candidateLevel < currentLevel;
+
+            break;
+        }
+
+        case StealingPolicy::lowestNote:
+            if (candidate->getCurrentlyPlayingNote() != current->getCurrentlyPlayingNote())
+                return candidate->getCurrentlyPlayingNote() < current->getCurrentlyPlayingNote();
+
+            break;
+
+        case StealingPolicy::releasingFirst:
+            if (candidate->isPlayingButReleased() != current->isPlayingButReleased())
+                return candidate->isPlayingButReleased();
+
+            break;
+
+        case StealingPolicy::oldest:
+        default:
+            break;
+    }
+
+    //every policy falls back to the oldest voice on a tie
+    return candidate->wasStartedBefore (*current);
+}
+
+//==============================================================================
+void ParallelSynthesiser::retireFinishedVoices() noexcept
+{
+    int numStillActive = 0;
+
+    for (int i = 0; i < numActiveVoices; ++i)
+    {
+        auto voiceIndex = activeVoices[i];
+
+        if (voices.getUnchecked (voiceIndex)->isVoiceActive())
+            activeVoices[numStillActive++] = voiceIndex;
+        else
+            freeVoices[numFreeVoices++] = voiceIndex;
+    }
+
+    numActiveVoices = numStillActive;
+}
+
+bool ParallelSynthesiser::isSilent() const noexcept
+{
+    const ScopedLock sl (lock);
+
+    return numActiveVoices == 0 && (voiceMixer == nullptr || ! voiceMixer->isRinging());
+}
+
+void ParallelSynthesiser::handleMidiEvent (const MidiMessage& message)
+{
+    //first, so a note-on that follows a controller in the same block already sees its value
+    if (midiObserver != nullptr)
+        midiObserver->handleMidiEvent (message);
+
+    Synthesiser::handleMidiEvent (message);
+}
+
+void ParallelSynthesiser::renderVoices (AudioBuffer<float>& outputAudio, int startSample, int numSamples)
+{
+    jassert (voiceBuffers.size() >= voices.size());
+
+    retireFinishedVoices();
+
+    //nothing to render and nothing to mix: the output is already clear
+    if (numActiveVoices == 0 && (voiceMixer == nullptr || ! voiceMixer->isRinging()))
+        return;
+
+    samplesThisTime = numSamples;
+    scheduler.perform (*this, numActiveVoices);
+
+    for (int i = 0; i < numActiveVoices; ++i)
+    {
+        voiceCycles += taskCycles[i];
+        maxVoiceCycles = jmax (maxVoiceCycles, taskCycles[i]);
+
+        auto voiceIndex = activeVoices[i];
+        outputFunction (*voices.getUnchecked (voiceIndex), voiceOutputs[voiceIndex]);
+    }
+
+    if (voiceMixer != nullptr)
+    {
+        voiceMixer->mixVoices (outputAudio, startSample, numSamples, voiceBuffers, voiceOutputs,
+                               activeVoices, numActiveVoices);
+        return;
+    }
+
+    //summed in list order whichever thread rendered them, so scheduling never changes the result
+    for (int i = 0; i < numActiveVoices; ++i)
+    {
+        auto voiceIndex = activeVoices[i];
+        auto& voiceBuffer = *voiceBuffers.getUnchecked (voiceIndex);
+        auto& voiceOutput = voiceOutputs[voiceIndex];
+        auto numVoiceChannels = jmin (voiceOutput.numChannels, voiceBuffer.getNumChannels());
+
+        for (int channel = 0; channel < outputAudio.getNumChannels(); ++channel)
+            outputAudio.addFrom (channel, startSample, voiceBuffer, jmin (channel, numVoiceChannels - 1), 0, numSamples,
+                                 voiceOutput.gains[jmin (channel, VoiceOutput::maxChannels - 1)]);
+    }
+}
+
+void ParallelSynthesiser::runTask (int taskIndex)
+{
+    const ScopedAllocationGuard noAllocation;
+
+    //the flush-to-zero mode is per thread, so each worker sets its own
+    const ScopedNoDenormals noDenormals;
+
+    auto voiceIndex = activeVoices[taskIndex];
+    auto& voiceBuffer = *voiceBuffers.getUnchecked (voiceIndex);
+
+    jassert (samplesThisTime <= voiceBuffer.getNumSamples());
+
+    auto startCycles = PerformanceMonitor::getCycles();
+
+    voiceBuffer.clear (0, samplesThisTime);
+    voices.getUnchecked (voiceIndex)->renderNextBlock (voiceBuffer, 0, samplesThisTime);
+
+    taskCycles[taskIndex] = PerformanceMonitor::getCycles() - startCycles;
+}
@@ -0,0 +1,183 @@
+/*
+    File: ParallelSynthesiser.h
+    Description: A Synthesiser whose voices render into private buffers, optionally spread over a
+    VoiceRenderScheduler's worker threads, and are then summed in a fixed order. Because the final
+    mix never depends on which thread rendered what, the output is bit-identical to running with
+    no workers at all.
+
+    The voices live in one contiguous pool created by createVoices(), and the synth keeps a list
+    of the voices that are sounding, so a block costs O(active voices) however large the pool is.
+
+    A voice can render fewer channels than the output has, e.g. mono, and leave the spreading to
+    the mix: each voice describes how its buffer fans out with a VoiceOutput, and the panning
+    costs one multiply-add per output channel instead of a copy of the voice's whole DSP.
+
+    Every MIDI channel draws on the same pool, but each can be capped at a number of voices of its
+    own; a channel at its cap steals from its own notes rather than from the others'.
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "VoiceRenderScheduler.h"
+#include "PerformanceMonitor.h"
+
+//==============================================================================
+class ParallelSynthesiser   : public Synthesiser,
+                              private VoiceRenderScheduler::Job
+{
+public:
+    //which voice gives way when a note arrives and every voice is busy
+    enum class StealingPolicy
+    {
+        oldest = 1,         //the voice that started first
+        quietest,           //the voice whose envelope is lowest right now
+        lowestNote,         //the voice playing the lowest note
+        releasingFirst      //the oldest voice whose key is already up, else the oldest voice
+    };
+
+    //how a voice's buffer reaches the output: output channel c takes the voice's channel
+    //min (c, numChannels - 1), scaled by gains[min (c, maxChannels - 1)]
+    struct VoiceOutput
+    {
+        static constexpr int maxChannels = 2;
+
+        int numChannels = 1;
+        float gains[maxChannels] = { 1.0f, 1.0f };
+    };
+
+    //takes over from the plain sum of the voice buffers, e.g. to filter every voice at once.
+    //called on the audio thread with the lock held, once all the active voices have rendered
+    struct VoiceMixer
+    {
+        virtual ~VoiceMixer() = default;
+
+        virtual void mixVoices (AudioBuffer<float>& output, int startSample, int numSamples,
+                                const OwnedArray<AudioBuffer<float>>& voiceBuffers,
+                                const VoiceOutput* voiceOutputs, const int* voiceIndices,
+                                int numVoices) noexcept = 0;
+
+        //true while the mixer still has output of its own with no voices feeding it, e.g. filters
+        //ringing on; otherwise a block with no active voices skips the mix altogether
+        virtual bool isRinging() const noexcept     { return false; }
+    };
+
+    //sees every MIDI message the synth plays, just before the voices do, e.g. to keep track of
+    //the controllers. called on the audio thread with the lock held, between voice renders
+    struct MidiObserver
+    {
+        virtual ~MidiObserver() = default;
+
+        virtual void handleMidiEvent (const MidiMessage& message) noexcept = 0;
+    };
+
+    static constexpr int numMidiChannels = 16;
+
+    ParallelSynthesiser();
+    ~ParallelSynthesiser();
+
+    //replaces every voice with numVoices VoiceType objects allocated in one block. prepareVoice
+    //is called on each new voice before the audio thread can see it. VoiceType must provide
+    //float getCurrentLevel() const for the quietest policy and void getOutput (VoiceOutput&) const
+    //for the mix. call from the message thread; the audio thread is only held off for the
+    //pointer swap
+    template <typename VoiceType, typename PrepareFunction>
+    void createVoices (int numVoices, PrepareFunction prepareVoice)
+    {
+        numVoices = jmax (1, numVoices);
+        std::shared_ptr<VoiceType> newPool (new VoiceType[(size_t) numVoices], std::default_delete<VoiceType[]>());
+        Array<SynthesiserVoice*> newVoices;
+
+        for (int i = 0; i < numVoices; ++i)
+        {
+            auto& voice = newPool.get()[i];
+            prepareVoice (voice);
+            newVoices.add (&voice);
+        }
+
+        setVoicePool (std::move (newPool), newVoices,
+                      [] (const SynthesiserVoice& voice) { return static_cast<const VoiceType&> (voice).getCurrentLevel(); },
+                      [] (const SynthesiserVoice& voice, VoiceOutput& output) { static_cast<const VoiceType&> (voice).getOutput (output); });
+    }
+
+    //sizes one private buffer per voice. call whenever the block size or channel count grows;
+    //never from the audio thread
+    void prepare (int maximumBlockSize, int numChannels);
+
+    void setStealingPolicy (StealingPolicy newPolicy) noexcept      { stealingPolicy = (int) newPolicy; }
+    StealingPolicy getStealingPolicy() const noexcept               { return (StealingPolicy) stealingPolicy.load(); }
+
+    //the most voices notes on midiChannel (1 to 16) may hold at once, from any thread; 0 ignores
+    //the channel's notes altogether. every channel starts out unlimited
+    void setChannelVoiceLimit (int midiChannel, int maxVoices) noexcept;
+    int getChannelVoiceLimit (int midiChannel) const noexcept;
+
+    VoiceRenderScheduler& getScheduler() noexcept   { return scheduler; }
+
+    //nullptr (the default) sums the voice buffers. call from the audio thread between blocks;
+    //the mixer must outlive the synth or be removed first
+    void setVoiceMixer (VoiceMixer* newMixer) noexcept  { voiceMixer = newMixer; }
+
+    //nullptr (the default) for none. set before playback; the observer must outlive the synth
+    void setMidiObserver (MidiObserver* newObserver) noexcept   { midiObserver = newObserver; }
+
+    //audio thread only. cycles spent in voice renders since the last resetVoiceTimings(),
+    //summed over every voice and for the slowest single render
+    void resetVoiceTimings() noexcept               { voiceCycles = maxVoiceCycles = 0; }
+    uint64 getVoiceCycles() const noexcept          { return voiceCycles; }
+    uint64 getMaxVoiceCycles() const noexcept       { return maxVoiceCycles; }
+    int getNumActiveVoices() const noexcept         { return numActiveVoices; }
+
+    //true when no voice is sounding and the mixer has nothing ringing, so a block without MIDI
+    //would render nothing but silence
+    bool isSilent() const noexcept;
+
+protected:
+    using Synthesiser::renderVoices;
+    void renderVoices (AudioBuffer<float>& outputAudio, int startSample, int numSamples) override;
+    void handleMidiEvent (const MidiMessage& message) override;
+
+    SynthesiserVoice* findFreeVoice (SynthesiserSound* soundToPlay, int midiChannel,
+                                     int midiNoteNumber, bool stealIfNoneAvailable) const override;
+    SynthesiserVoice* findVoiceToSteal (SynthesiserSound* soundToPlay, int midiChannel,
+                                        int midiNoteNumber) const override;
+
+private:
+    using LevelFunction = float (*) (const SynthesiserVoice&);
+    using OutputFunction = void (*) (const SynthesiserVoice&, VoiceOutput&);
+
+    void setVoicePool (std::shared_ptr<void> newPool, const Array<SynthesiserVoice*>& newVoices,
+                       LevelFunction newLevelFunction, OutputFunction newOutputFunction);
+    void retireFinishedVoices() noexcept;
+    int countVoicesOnChannel (int midiChannel) const noexcept;
+
+    //midiChannel 0 steals from any channel
+    SynthesiserVoice* findVoiceToStealOnChannel (SynthesiserSound* soundToPlay, int midiChannel) const;
+    bool shouldStealInsteadOf (SynthesiserVoice* candidate, SynthesiserVoice* current) const noexcept;
+    void runTask (int taskIndex) override;
+
+    VoiceRenderScheduler scheduler;
+    std::shared_ptr<void> voicePool;
+    LevelFunction levelFunction = nullptr;
+    OutputFunction outputFunction = nullptr;
+    VoiceMixer* voiceMixer = nullptr;
+    MidiObserver* midiObserver = nullptr;
+    std::atomic<int> stealingPolicy { (int) StealingPolicy::oldest };
+    std::atomic<int> channelVoiceLimits[numMidiChannels];
+
+    OwnedArray<AudioBuffer<float>> voiceBuffers;
+    HeapBlock<VoiceOutput> voiceOutputs;    //one per voice, refreshed for the active ones each block
+    int preparedBlockSize = 0, preparedChannels = 0;
+
+    //fixed-capacity index lists, so claiming and retiring voices never allocates. they are only
+    //touched with the synth's lock held (note handling and rendering both run under it)
+    mutable HeapBlock<int> activeVoices, freeVoices;
+    mutable int numActiveVoices = 0, numFreeVoices = 0;
+    int samplesThisTime = 0;
+
+    //written by whichever thread rendered the task, summed by the audio thread afterwards
+    HeapBlock<uint64> taskCycles;
+    uint64 voiceCycles = 0, maxVoiceCycles = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParallelSynthesiser)
+};
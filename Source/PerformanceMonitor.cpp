@@ -0,0 +1,219 @@
+/*
+    File: PerformanceMonitor.cpp
+    Description: See PerformanceMonitor.h
+*/
+
+#include "PerformanceMonitor.h"
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+uint64 PerformanceMonitor::getCycles() noexcept
+{
+   #if JUCE_INTEL
+    return (uint64) __rdtsc();
+   #elif JUCE_ARM && defined (__aarch64__) && ! JUCE_MSVC
+    uint64 virtualCount;
+    asm volatile ("mrs %0, cntvct_el0" : "=r" (virtualCount));
+    return virtualCount;
+   #else
+    return (uint64) Time::getHighResolutionTicks();
+   #endif
+}
+
+//==============================================================================
+String PerformanceMonitor::Snapshot::toJSON() const
+{
+    auto* object = new DynamicObject();
+    var result (object);
+
+    object->setProperty ("averageLoad", averageLoad);
+    object->setProperty ("p99Load", p99Load);
+    object->setProperty ("maxLoad", maxLoad);
+    object->setProperty ("synthLoad", synthLoad);
+    object->setProperty ("averageVoiceMicroseconds", averageVoiceMicroseconds);
+    object->setProperty ("maxVoiceMicroseconds", maxVoiceMicroseconds);
+    object->setProperty ("activeVoices", activeVoices);
+    object->setProperty ("blocks", numBlocks);
+    object->setProperty ("deadlineMisses", deadlineMisses);
+    object->setProperty ("droppedRecords", droppedRecords);
+    object->setProperty ("deviceXRuns", deviceXRuns);
+
+    Array<var> bins;
+
+    for (auto count : histogram)
+        bins.add (count);
+
+    object->setProperty ("loadHistogram", bins);
+
+    return JSON::toString (result);
+}
+
+//==============================================================================
+PerformanceMonitor::PerformanceMonitor()
+    : startCycles (getCycles()),
+      startTicks (Time::getHighResolutionTicks())
+{
+}
+
+PerformanceMonitor::~PerformanceMonitor() {}
+
+void PerformanceMonitor::pushCurrentRecord() noexcept
+{
+    int start1, size1, start2, size2;
+    ringFifo.prepareToWrite (1, start1, size1, start2, size2);
+
+    if (size1 + size2 == 0)
+        ++droppedRecords;
+    else
+        ring[size1 > 0 ? start1 : start2] = currentRecord;
+
+    ringFifo.finishedWrite (size1 + size2);
+    currentRecord = {};
+}
+
+//==============================================================================
+double PerformanceMonitor::cyclesPerSecond() const noexcept
+{
+    //calibrated against the high resolution clock over the monitor's whole lifetime, so the
+    //estimate keeps getting better the longer the app runs
+    auto elapsedSeconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+    auto elapsedCycles = (double) (getCycles() - startCycles);
+
+    return elapsedSeconds > 0.0 && elapsedCycles > 0.0 ? elapsedCycles / elapsedSeconds : 1.0;
+}
+
+void PerformanceMonitor::update()
+{
+    auto secondsPerCycle = 1.0 / cyclesPerSecond();
+    auto numReady = ringFifo.getNumReady();
+
+    if (numReady > 0)
+    {
+        int start1, size1, start2, size2;
+        ringFifo.prepareToRead (numReady, start1, size1, start2, size2);
+
+        for (int i = 0; i < size1; ++i)
+            addToWindow (ring[start1 + i], secondsPerCycle);
+
+        for (int i = 0; i < size2; ++i)
+            addToWindow (ring[start2 + i], secondsPerCycle);
+
+        ringFifo.finishedRead (size1 + size2);
+    }
+
+    if (csvStream != nullptr)
+        csvStream->flush();
+
+    updateSnapshot();
+}
+
+void PerformanceMonitor::addToWindow (const BlockRecord& record, double secondsPerCycle)
+{
+    if (record.numSamples <= 0)
+        return;
+
+    auto budgetSeconds = record.numSamples / sampleRate.load();
+    auto toMicroseconds = secondsPerCycle * 1.0e6;
+    auto load = (float) (record.callbackCycles * secondsPerCycle / budgetSeconds);
+
+    loadHistory[historyPosition] = load;
+    synthLoadHistory[historyPosition] = (float) (record.synthCycles * secondsPerCycle / budgetSeconds);
+    voiceMicrosecondsHistory[historyPosition] = record.activeVoices > 0 ? (float) (record.voiceCycles * toMicroseconds / record.activeVoices) : 0.0f;
+    maxVoiceMicrosecondsHistory[historyPosition] = (float) (record.maxVoiceCycles * toMicroseconds);
+
+    historyPosition = (historyPosition + 1) % windowSize;
+    historySize = jmin (historySize + 1, (int) windowSize);
+    lastActiveVoices = record.activeVoices;
+
+    ++numBlocks;
+
+    if (load >= 1.0f)
+        ++deadlineMisses;
+
+    if (csvStream != nullptr)
+        *csvStream << numBlocks << ',' << record.numSamples << ','
+                   << String (record.callbackCycles * toMicroseconds, 2) << ','
+                   << String (record.synthCycles * toMicroseconds, 2) << ','
+                   << String (record.voiceCycles * toMicroseconds, 2) << ','
+                   << String (record.maxVoiceCycles * toMicroseconds, 2) << ','
+                   << record.activeVoices << ',' << String (load, 4) << newLine;
+}
+
+void PerformanceMonitor::updateSnapshot()
+{
+    Snapshot newSnapshot;
+    newSnapshot.numBlocks = numBlocks;
+    newSnapshot.deadlineMisses = deadlineMisses;
+    newSnapshot.droppedRecords = droppedRecords.load();
+    newSnapshot.deviceXRuns = deviceXRuns;
+    newSnapshot.activeVoices = lastActiveVoices;
+
+    if (historySize > 0)
+    {
+        double loadSum = 0.0, synthSum = 0.0, voiceSum = 0.0;
+
+        for (int i = 0; i < historySize; ++i)
+        {
+            auto load = loadHistory[i];
+            loadSum += load;
+            synthSum += synthLoadHistory[i];
+            voiceSum += voiceMicrosecondsHistory[i];
+
+            newSnapshot.maxLoad = jmax (newSnapshot.maxLoad, (double) load);
+            newSnapshot.maxVoiceMicroseconds = jmax (newSnapshot.maxVoiceMicroseconds, (double) maxVoiceMicrosecondsHistory[i]);
+            ++newSnapshot.histogram[jlimit (0, Snapshot::numHistogramBins - 1, (int) (load * 20.0f))];
+        }
+
+        newSnapshot.averageLoad = loadSum / historySize;
+        newSnapshot.synthLoad = synthSum / historySize;
+        newSnapshot.averageVoiceMicroseconds = voiceSum / historySize;
+
+        std::copy (loadHistory, loadHistory + historySize, sortScratch);
+        auto* p99 = sortScratch + (historySize - 1) * 99 / 100;
+        std::nth_element (sortScratch, p99, sortScratch + historySize);
+        newSnapshot.p99Load = *p99;
+    }
+
+    const SpinLock::ScopedLockType sl (snapshotLock);
+    snapshot = newSnapshot;
+}
+
+void PerformanceMonitor::setDeviceXRuns (int numXRuns) noexcept
+{
+    deviceXRuns = numXRuns;
+}
+
+PerformanceMonitor::Snapshot PerformanceMonitor::getSnapshot() const
+{
+    const SpinLock::ScopedLockType sl (snapshotLock);
+    return snapshot;
+}
+
+//==============================================================================
+bool PerformanceMonitor::startCsvLog (const File& file)
+{
+    file.deleteFile();
+    csvStream.reset (file.createOutputStream());
+
+    if (csvStream == nullptr)
+        return false;
+
+    *csvStream << "block,samples,callback_us,synth_us,voices_us,max_voice_us,active_voices,load" << newLine;
+    return true;
+}
+
+void PerformanceMonitor::stopCsvLog()
+{
+    csvStream.reset();
+}
+
+bool PerformanceMonitor::writeJSON (const File& file) const
+{
+    return file.replaceWithText (getSnapshot().toJSON());
+}
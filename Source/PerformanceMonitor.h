@@ -0,0 +1,109 @@
+/*
+    File: PerformanceMonitor.h
+    Description: Real-time timing of the audio callback. The audio thread stamps each block with
+    cycle counter readings and pushes one record into a wait-free ring; the message thread drains
+    the ring, turns the cycles into load against the block's real-time budget and keeps rolling
+    statistics for the GUI overlay, the CSV/JSON dumps and the UDP endpoint.
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class PerformanceMonitor
+{
+public:
+    //the CPU's time-stamp counter where there is one, otherwise the high resolution clock.
+    //cheap enough to read around every voice
+    static uint64 getCycles() noexcept;
+
+    struct BlockRecord
+    {
+        uint64 callbackCycles = 0;      //the whole device callback
+        uint64 synthCycles = 0;         //SynthAudioSource::getNextAudioBlock
+        uint64 voiceCycles = 0;         //every voice render, summed across threads
+        uint64 maxVoiceCycles = 0;      //the slowest single voice render
+        int numSamples = 0;
+        int activeVoices = 0;
+    };
+
+    struct Snapshot
+    {
+        static constexpr int numHistogramBins = 21;     //5% wide, the last one is >= 100%
+
+        double averageLoad = 0.0, p99Load = 0.0, maxLoad = 0.0;    //fractions of the block budget
+        double synthLoad = 0.0;                                     //average, SynthAudioSource only
+        double averageVoiceMicroseconds = 0.0, maxVoiceMicroseconds = 0.0;
+        int activeVoices = 0;
+        int64 numBlocks = 0, deadlineMisses = 0, droppedRecords = 0;
+        int deviceXRuns = -1;                                       //-1 if the device can't tell
+        int histogram[numHistogramBins] = {};
+
+        String toJSON() const;
+    };
+
+    PerformanceMonitor();
+    ~PerformanceMonitor();
+
+    //==============================================================================
+    //audio thread. the record for the block being rendered; each stage fills in its part
+    BlockRecord& getCurrentRecord() noexcept            { return currentRecord; }
+
+    //queues the current record and starts a fresh one. wait-free; if the message thread has
+    //fallen far behind the record is dropped and counted instead
+    void pushCurrentRecord() noexcept;
+
+    //any thread; used to turn sample counts into a time budget
+    void setSampleRate (double newSampleRate) noexcept  { sampleRate = newSampleRate; }
+
+    //==============================================================================
+    //message thread. drains the ring, updates the statistics over the last window of blocks
+    //and appends to the CSV log if one is open
+    void update();
+
+    void setDeviceXRuns (int numXRuns) noexcept;
+
+    //any thread
+    Snapshot getSnapshot() const;
+
+    //message thread. one row per block: cycles are converted to microseconds
+    bool startCsvLog (const File& file);
+    void stopCsvLog();
+
+    bool writeJSON (const File& file) const;
+
+    static constexpr int windowSize = 2048;
+
+private:
+    static constexpr int ringSize = 1024;
+
+    //audio side
+    BlockRecord currentRecord;
+    BlockRecord ring[ringSize];
+    AbstractFifo ringFifo { ringSize };
+    std::atomic<int64> droppedRecords { 0 };
+    std::atomic<double> sampleRate { 44100.0 };
+
+    //message side
+    double cyclesPerSecond() const noexcept;
+    void addToWindow (const BlockRecord& record, double secondsPerCycle);
+    void updateSnapshot();
+
+    uint64 startCycles = 0;
+    int64 startTicks = 0;
+
+    float loadHistory[windowSize] = {}, synthLoadHistory[windowSize] = {};
+    float voiceMicrosecondsHistory[windowSize] = {}, maxVoiceMicrosecondsHistory[windowSize] = {};
+    float sortScratch[windowSize] = {};
+    int historySize = 0, historyPosition = 0, lastActiveVoices = 0;
+    int64 numBlocks = 0, deadlineMisses = 0;
+    int deviceXRuns = -1;
+
+    std::unique_ptr<FileOutputStream> csvStream;
+
+    mutable SpinLock snapshotLock;
+    Snapshot snapshot;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PerformanceMonitor)
+};
@@ -0,0 +1,100 @@
+/*
+    File: PerformanceServer.cpp
+    Description: See PerformanceServer.h
+*/
+
+#include "PerformanceServer.h"
+
+namespace
+{
+    //OSC strings are null-terminated and padded with nulls to a multiple of four bytes
+    void writeOscString (MemoryOutputStream& stream, const char* text)
+    {
+        auto length = std::strlen (text);
+        stream.write (text, length);
+
+        for (auto padding = 4 - length % 4; padding > 0; --padding)
+            stream.writeByte (0);
+    }
+}
+
+PerformanceServer::PerformanceServer (const PerformanceMonitor& monitorToServe)
+    : Thread ("Performance server"),
+      monitor (monitorToServe)
+{
+}
+
+PerformanceServer::~PerformanceServer()
+{
+    stop();
+}
+
+bool PerformanceServer::start (int port)
+{
+    stop();
+
+    socket.reset (new DatagramSocket());
+
+    if (! socket->bindToPort (port, "127.0.0.1"))
+    {
+        socket.reset();
+        return false;
+    }
+
+    startThread();
+    return true;
+}
+
+void PerformanceServer::stop()
+{
+    signalThreadShouldExit();
+
+    if (socket != nullptr)
+        socket->shutdown();
+
+    stopThread (1000);
+    socket.reset();
+}
+
+MemoryBlock PerformanceServer::createOscMessage (const PerformanceMonitor::Snapshot& snapshot)
+{
+    MemoryOutputStream stream;
+
+    writeOscString (stream, "/synth/perf");
+    writeOscString (stream, ",ffffffiiiii");
+
+    stream.writeFloatBigEndian ((float) snapshot.averageLoad);
+    stream.writeFloatBigEndian ((float) snapshot.p99Load);
+    stream.writeFloatBigEndian ((float) snapshot.maxLoad);
+    stream.writeFloatBigEndian ((float) snapshot.synthLoad);
+    stream.writeFloatBigEndian ((float) snapshot.averageVoiceMicroseconds);
+    stream.writeFloatBigEndian ((float) snapshot.maxVoiceMicroseconds);
+    stream.writeIntBigEndian (snapshot.activeVoices);
+    stream.writeIntBigEndian ((int) snapshot.numBlocks);
+    stream.writeIntBigEndian ((int) snapshot.deadlineMisses);
+    stream.writeIntBigEndian ((int) snapshot.droppedRecords);
+    stream.writeIntBigEndian (snapshot.deviceXRuns);
+
+    return stream.getMemoryBlock();
+}
+
+void PerformanceServer::run()
+{
+    char request[1024];
+
+    while (! threadShouldExit())
+    {
+        if (socket->waitUntilReady (true, 200) <= 0)
+            continue;
+
+        String senderAddress;
+        int senderPort = 0;
+
+        //whatever was asked, the answer is the current snapshot
+        if (socket->read (request, (int) sizeof (request), false, senderAddress, senderPort) <= 0)
+            continue;
+
+        auto message = createOscMessage (monitor.getSnapshot());
+        socket->write (senderAddress, senderPort, message.getData(), (int) message.getSize());
+    }
+}
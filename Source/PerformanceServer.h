@@ -0,0 +1,42 @@
+/*
+    File: PerformanceServer.h
+    Description: A UDP endpoint on the loopback interface for external monitoring. Any datagram
+    sent to the port is answered, to the sender, with one OSC message holding the monitor's
+    latest snapshot:
+
+        /synth/perf ,ffffffiiiii  averageLoad p99Load maxLoad synthLoad
+                                  averageVoiceMicroseconds maxVoiceMicroseconds
+                                  activeVoices blocks deadlineMisses droppedRecords deviceXRuns
+
+    Loads are fractions of the block's real-time budget. Runs on its own thread and never
+    touches the audio thread.
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PerformanceMonitor.h"
+
+//==============================================================================
+class PerformanceServer   : private Thread
+{
+public:
+    static constexpr int defaultPort = 9010;
+
+    PerformanceServer (const PerformanceMonitor& monitorToServe);
+    ~PerformanceServer();
+
+    //binds to 127.0.0.1 on the given port and starts answering; false if the port is taken
+    bool start (int port = defaultPort);
+    void stop();
+
+    static MemoryBlock createOscMessage (const PerformanceMonitor::Snapshot& snapshot);
+
+private:
+    void run() override;
+
+    const PerformanceMonitor& monitor;
+    std::unique_ptr<DatagramSocket> socket;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PerformanceServer)
+};
@@ -0,0 +1,250 @@
+/*
+    File: RenderCache.cpp
+    Description: See RenderCache.h
+*/
+
+#include "RenderCache.h"
+
+namespace
+{
+    static_assert (sizeof (RenderCache::NoteKey) == 80, "NoteKey must have no padding, it is hashed byte for byte");
+
+    //bumped whenever the file layout or anything that changes a voice's output changes, so old
+    //files are ignored rather than played
+    constexpr uint32 fileVersion = 2;
+    const char fileMagic[8] = { 'S', 'Y', 'N', 'T', 'H', 'P', 'C', 'M' };
+
+    //the samples follow the header planar, one channel after the other, and stay 16-byte aligned
+    //in the mapping. there is no padding anywhere, so a value-initialised header writes its
+    //reserved words as zeros and nothing undefined reaches the file
+    struct FileHeader
+    {
+        char magic[8];
+        uint32 version;
+        int32 numChannels, numSamples;
+        float gains[RenderCache::maxChannels];
+        uint32 reserved[5];
+        RenderCache::NoteKey key;
+    };
+
+    static_assert (sizeof (FileHeader) % 16 == 0, "the samples must start aligned");
+}
+
+//==============================================================================
+uint64 RenderCache::NoteKey::getHash() const noexcept
+{
+    auto* bytes = reinterpret_cast<const uint8*> (this);
+    uint64 hash = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < sizeof (NoteKey); ++i)
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+
+    return hash;
+}
+
+bool RenderCache::NoteKey::operator== (const NoteKey& other) const noexcept
+{
+    return std::memcmp (this, &other, sizeof (NoteKey)) == 0;
+}
+
+//==============================================================================
+RenderCache::Segment::Segment (AudioBuffer<float>&& samples, const float* newGains)
+    : buffer (std::move (samples)),
+      numChannels (jmin (buffer.getNumChannels(), maxChannels)),
+      numSamples (buffer.getNumSamples())
+{
+    for (int channel = 0; channel < maxChannels; ++channel)
+    {
+        channels[channel] = numChannels > 0 ? buffer.getReadPointer (jmin (channel, numChannels - 1)) : nullptr;
+        gains[channel] = newGains[channel];
+    }
+}
+
+RenderCache::Segment::Segment (std::unique_ptr<MemoryMappedFile> newMapping, const float* samples,
+                               int channelCount, int sampleCount, const float* newGains)
+    : mapping (std::move (newMapping)),
+      numChannels (jlimit (0, maxChannels, channelCount)),
+      numSamples (sampleCount)
+{
+    for (int channel = 0; channel < maxChannels; ++channel)
+    {
+        channels[channel] = numChannels > 0 ? samples + (size_t) jmin (channel, numChannels - 1) * (size_t) numSamples : nullptr;
+        gains[channel] = newGains[channel];
+    }
+}
+
+const float* RenderCache::Segment::getReadPointer (int channel) const noexcept
+{
+    jassert (isPositiveAndBelow (channel, numChannels));
+    return channels[jlimit (0, maxChannels - 1, channel)];
+}
+
+float RenderCache::Segment::getGain (int outputChannel) const noexcept
+{
+    return gains[jlimit (0, maxChannels - 1, outputChannel)];
+}
+
+size_t RenderCache::Segment::getSizeInBytes() const noexcept
+{
+    return sizeof (FileHeader) + sizeof (float) * (size_t) numChannels * (size_t) numSamples;
+}
+
+void RenderCache::Segment::addTo (AudioBuffer<float>& output, int startSample, int segmentStart, int numToAdd) const noexcept
+{
+    numToAdd = jmin (numToAdd, numSamples - segmentStart);
+
+    if (numChannels == 0 || numToAdd <= 0)
+        return;
+
+    //a mono voice feeds every output channel, as in ParallelSynthesiser::renderVoices
+    for (int channel = 0; channel < output.getNumChannels(); ++channel)
+        output.addFrom (channel, startSample, channels[jmin (channel, maxChannels - 1)] + segmentStart,
+                        numToAdd, getGain (channel));
+}
+
+//==============================================================================
+RenderCache::RenderCache (size_t budget, const File& storeDirectory)
+    : memoryBudget (budget), directory (storeDirectory)
+{
+    if (directory != File())
+        directory.createDirectory();
+}
+
+RenderCache::~RenderCache() {}
+
+std::shared_ptr<const RenderCache::Segment> RenderCache::find (const NoteKey& key)
+{
+    auto hash = key.getHash();
+    auto found = index.find (hash);
+
+    if (found != index.end() && found->second->key == key)
+    {
+        //back to the front of the list
+        entries.splice (entries.begin(), entries, found->second);
+        ++statistics.memoryHits;
+        return entries.front().segment;
+    }
+
+    if (auto segment = load (key, hash))
+    {
+        ++statistics.diskHits;
+        insert (key, hash, segment);
+        return segment;
+    }
+
+    ++statistics.misses;
+    return {};
+}
+
+void RenderCache::add (const NoteKey& key, std::shared_ptr<const Segment> segment)
+{
+    jassert (segment != nullptr);
+
+    auto hash = key.getHash();
+
+    if (directory != File() && ! save (key, hash, *segment))
+        ++statistics.diskWriteFailures;
+
+    insert (key, hash, std::move (segment));
+}
+
+void RenderCache::insert (const NoteKey& key, uint64 hash, std::shared_ptr<const Segment> segment)
+{
+    //a colliding key replaces whatever had the same hash
+    remove (hash);
+
+    memoryUsed += segment->getSizeInBytes();
+    entries.push_front ({ key, std::move (segment) });
+    index[hash] = entries.begin();
+
+    //the newest entry always stays, even if it alone is over budget
+    while (memoryUsed > memoryBudget && entries.size() > 1)
+    {
+        remove (entries.back().key.getHash());
+        ++statistics.evictions;
+    }
+}
+
+void RenderCache::remove (uint64 hash)
+{
+    auto found = index.find (hash);
+
+    if (found == index.end())
+        return;
+
+    memoryUsed -= found->second->segment->getSizeInBytes();
+    entries.erase (found->second);
+    index.erase (found);
+}
+
+//==============================================================================
+File RenderCache::getFileFor (uint64 hash) const
+{
+    return directory.getChildFile (String::toHexString ((int64) hash).paddedLeft ('0', 16) + ".pcm");
+}
+
+std::shared_ptr<const RenderCache::Segment> RenderCache::load (const NoteKey& key, uint64 hash) const
+{
+    if (directory == File())
+        return {};
+
+    auto file = getFileFor (hash);
+
+    if (! file.existsAsFile())
+        return {};
+
+    std::unique_ptr<MemoryMappedFile> mapping (new MemoryMappedFile (file, MemoryMappedFile::readOnly, false));
+
+    if (mapping->getData() == nullptr || mapping->getSize() < sizeof (FileHeader))
+        return {};
+
+    FileHeader header;
+    std::memcpy (&header, mapping->getData(), sizeof (header));
+
+    //anything truncated, from another version or for a colliding key counts as a miss and is
+    //overwritten by the fresh render
+    if (std::memcmp (header.magic, fileMagic, sizeof (fileMagic)) != 0
+         || header.version != fileVersion
+         || header.key != key
+         || ! isPositiveAndNotGreaterThan (header.numChannels, maxChannels)
+         || header.numSamples < 0
+         || mapping->getSize() < sizeof (FileHeader) + sizeof (float) * (size_t) header.numChannels * (size_t) header.numSamples)
+        return {};
+
+    auto* samples = reinterpret_cast<const float*> (static_cast<const char*> (mapping->getData()) + sizeof (FileHeader));
+
+    return std::make_shared<const Segment> (std::move (mapping), samples, header.numChannels, header.numSamples, header.gains);
+}
+
+bool RenderCache::save (const NoteKey& key, uint64 hash, const Segment& segment) const
+{
+    FileHeader header {};
+    std::memcpy (header.magic, fileMagic, sizeof (fileMagic));
+    header.version = fileVersion;
+    header.numChannels = segment.getNumChannels();
+    header.numSamples = segment.getNumSamples();
+    header.key = key;
+
+    for (int channel = 0; channel < maxChannels; ++channel)
+        header.gains[channel] = segment.getGain (channel);
+
+    TemporaryFile temporary (getFileFor (hash));
+
+    {
+        FileOutputStream stream (temporary.getFile());
+
+        if (! stream.openedOk() || ! stream.write (&header, sizeof (header)))
+            return false;
+
+        for (int channel = 0; channel < segment.getNumChannels(); ++channel)
+            if (! stream.write (segment.getReadPointer (channel), sizeof (float) * (size_t) segment.getNumSamples()))
+                return false;
+
+        stream.flush();
+
+        if (stream.getStatus().failed())
+            return false;
+    }
+
+    return temporary.overwriteTargetFileWithTemporary();
+}
@@ -0,0 +1,126 @@
+/*
+    File: RenderCache.h
+    Description: Content-addressed store of rendered notes for the offline tools. A note's samples
+    depend only on its NoteKey (the note, velocity and length plus every setting a voice reads),
+    so a batch that plays the same notes again and again only has to synthesise each one once.
+
+    Recently used segments stay in memory, in a least-recently-used list bounded in bytes. With a
+    directory, every rendered segment is also written there, one file per key, and read back
+    through a memory-mapped file on a later miss, so the store carries over from one run or
+    process to the next. Files are written to a temporary and moved into place, so concurrent
+    jobs sharing a directory only ever see complete ones. They hold native-endian floats and are
+    not meant to move between machines.
+
+    Not thread-safe: one cache per render thread.
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <list>
+#include <unordered_map>
+
+//==============================================================================
+class RenderCache
+{
+public:
+    //as many channels as a voice renders
+    static constexpr int maxChannels = 2;
+
+    //everything a rendered note depends on. stored and compared byte for byte, so the fields
+    //are laid out with no padding bytes that could differ between two equal keys
+    struct NoteKey
+    {
+        double sampleRate = 0.0;
+        int64 lengthInSamples = 0;      //from note-on to note-off, at sampleRate
+        float velocity = 0.0f;
+        float q = 0.0f, spread = 0.0f;
+        float attack = 0.0f, decay = 0.0f, sustain = 0.0f, release = 0.0f;
+        float velocityQ = 0.0f;
+        int32 midiNoteNumber = 0;
+        int32 voiceRate = 1;
+        int32 topology = 0, panLaw = 0, noiseColour = 0, stereoNoise = 0;
+        int32 velocityCurve = 1;        //a fixed VelocityCurve::Shape; a custom curve isn't in the key
+        uint32 noiseSeed = 0;
+
+        //FNV-1a over the key's bytes
+        uint64 getHash() const noexcept;
+
+        bool operator== (const NoteKey& other) const noexcept;
+        bool operator!= (const NoteKey& other) const noexcept     { return ! operator== (other); }
+    };
+
+    //==============================================================================
+    //a rendered note: the channels a voice rendered and the gains that pan them into the output,
+    //either owned or read straight out of a mapped file
+    class Segment
+    {
+    public:
+        Segment (AudioBuffer<float>&& samples, const float* gains);
+        Segment (std::unique_ptr<MemoryMappedFile> mapping, const float* samples,
+                 int numChannels, int numSamples, const float* gains);
+
+        int getNumChannels() const noexcept             { return numChannels; }
+        int getNumSamples() const noexcept              { return numSamples; }
+        const float* getReadPointer (int channel) const noexcept;
+        float getGain (int outputChannel) const noexcept;
+        size_t getSizeInBytes() const noexcept;
+
+        //adds the segment's samples from segmentStart on into output from startSample, panned
+        //the way the synth pans a voice
+        void addTo (AudioBuffer<float>& output, int startSample, int segmentStart, int numSamples) const noexcept;
+
+    private:
+        AudioBuffer<float> buffer;
+        std::unique_ptr<MemoryMappedFile> mapping;
+        const float* channels[maxChannels] = {};
+        int numChannels = 0, numSamples = 0;
+        float gains[maxChannels] = { 1.0f, 1.0f };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Segment)
+    };
+
+    struct Statistics
+    {
+        int64 memoryHits = 0, diskHits = 0, misses = 0, evictions = 0;
+        int64 diskWriteFailures = 0;
+    };
+
+    //==============================================================================
+    //memoryBudget is in bytes. with directory left as File() nothing goes to disk
+    explicit RenderCache (size_t memoryBudget, const File& directory = {});
+    ~RenderCache();
+
+    //the segment for key, from memory or disk, or null on a miss. a segment stays valid for as
+    //long as the caller holds it, evicted or not
+    std::shared_ptr<const Segment> find (const NoteKey& key);
+
+    //keeps a freshly rendered segment in memory and writes it to the directory
+    void add (const NoteKey& key, std::shared_ptr<const Segment> segment);
+
+    const Statistics& getStatistics() const noexcept    { return statistics; }
+    size_t getMemoryUsed() const noexcept               { return memoryUsed; }
+
+private:
+    struct Entry
+    {
+        NoteKey key;
+        std::shared_ptr<const Segment> segment;
+    };
+
+    File getFileFor (uint64 hash) const;
+    std::shared_ptr<const Segment> load (const NoteKey& key, uint64 hash) const;
+    bool save (const NoteKey& key, uint64 hash, const Segment& segment) const;
+    void insert (const NoteKey& key, uint64 hash, std::shared_ptr<const Segment> segment);
+    void remove (uint64 hash);
+
+    //most recently used first
+    std::list<Entry> entries;
+    std::unordered_map<uint64, std::list<Entry>::iterator> index;
+
+    size_t memoryBudget, memoryUsed = 0;
+    File directory;
+    Statistics statistics;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderCache)
+};
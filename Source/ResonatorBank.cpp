@@ -0,0 +1,169 @@
+/*
+    File: ResonatorBank.cpp
+    Description: See ResonatorBank.h
+*/
+
+#include "ResonatorBank.h"
+
+namespace
+{
+    //a resonator with no input sleeps once its filter state, scaled by the (1 + Q) makeup gain
+    //the mix gets after the bank, falls below this: about -100 dB at the output
+    constexpr float sleepLevel = 1.0e-5f;
+}
+
+ResonatorBank::ResonatorBank (int capacity)
+    : voiceCapacity (jmax (1, capacity)),
+      voiceNotes ((size_t) voiceCapacity, true)
+{
+    for (int note = 0; note < numResonators; ++note)
+    {
+        resonators[note].frequency = MidiMessage::getMidiNoteInHertz (note);
+        inputs.add (new AudioBuffer<float> (maxChannels, 0));
+    }
+}
+
+ResonatorBank::~ResonatorBank() {}
+
+void ResonatorBank::prepare (double sampleRate, int maximumBlockSize)
+{
+    preparedBlockSize = maximumBlockSize;
+    filters.prepare (sampleRate, maximumBlockSize);
+
+    for (auto* input : inputs)
+    {
+        input->setSize (maxChannels, maximumBlockSize, false, false, true);
+        input->clear();
+    }
+
+    for (int note = 0; note < numResonators; ++note)
+        sleep (note);
+
+    numAwake = 0;
+}
+
+void ResonatorBank::setEnabled (bool shouldBeEnabled) noexcept
+{
+    for (int i = 0; i < numAwake; ++i)
+        sleep (awakeNotes[i]);
+
+    numAwake = 0;
+    filters.setEnabled (shouldBeEnabled);
+    enabled = shouldBeEnabled;
+}
+
+void ResonatorBank::startVoice (int voiceIndex, int midiNoteNumber) noexcept
+{
+    jassert (isPositiveAndBelow (voiceIndex, voiceCapacity));
+
+    if (isPositiveAndBelow (voiceIndex, voiceCapacity))
+        voiceNotes[voiceIndex] = jlimit (0, numResonators - 1, midiNoteNumber);
+}
+
+void ResonatorBank::sleep (int note) noexcept
+{
+    auto& resonator = resonators[note];
+    resonator.isAwake = false;
+
+    //retuning to the same frequency only clears the state
+    filters.startVoice (note, resonator.frequency);
+}
+
+//==============================================================================
+void ResonatorBank::feed (int note, const AudioBuffer<float>& voiceBuffer,
+                          const ParallelSynthesiser::VoiceOutput& voiceOutput, int numSamples) noexcept
+{
+    auto& resonator = resonators[note];
+    auto& input = *inputs.getUnchecked (note);
+    auto& output = outputs[note];
+    auto numVoiceChannels = jlimit (1, maxChannels, jmin (voiceOutput.numChannels, voiceBuffer.getNumChannels()));
+
+    //the last voice to feed a resonator pans it; voices on one note share a pan anyway
+    for (int channel = 0; channel < maxChannels; ++channel)
+        output.gains[channel] = voiceOutput.gains[channel];
+
+    if (! resonator.isFed)
+    {
+        //a resonator goes stereo when a stereo voice feeds it and stays so until it sleeps
+        if (! resonator.isAwake)
+        {
+            resonator.isAwake = true;
+            awakeNotes[numAwake++] = note;
+            output.numChannels = numVoiceChannels;
+        }
+        else
+        {
+            output.numChannels = jmax (output.numChannels, numVoiceChannels);
+        }
+
+        resonator.isFed = true;
+        resonator.isInputClear = false;
+
+        for (int channel = 0; channel < output.numChannels; ++channel)
+            input.copyFrom (channel, 0, voiceBuffer, jmin (channel, numVoiceChannels - 1), 0, numSamples);
+
+        return;
+    }
+
+    //a mono voice's channel feeds both sides of a stereo resonator
+    if (numVoiceChannels > output.numChannels)
+    {
+        input.copyFrom (1, 0, input, 0, 0, numSamples);
+        output.numChannels = numVoiceChannels;
+    }
+
+    for (int channel = 0; channel < output.numChannels; ++channel)
+        input.addFrom (channel, 0, voiceBuffer, jmin (channel, numVoiceChannels - 1), 0, numSamples);
+}
+
+void ResonatorBank::mixVoices (AudioBuffer<float>& output, int startSample, int numSamples,
+                               const OwnedArray<AudioBuffer<float>>& voiceBuffers,
+                               const ParallelSynthesiser::VoiceOutput* voiceOutputs,
+                               const int* voiceIndices, int numVoices) noexcept
+{
+    jassert (numSamples <= preparedBlockSize);
+    numSamples = jmin (numSamples, preparedBlockSize);
+
+    if (numSamples <= 0)
+        return;
+
+    for (int i = 0; i < numVoices; ++i)
+    {
+        auto voiceIndex = voiceIndices[i];
+        feed (voiceNotes[voiceIndex], *voiceBuffers.getUnchecked (voiceIndex), voiceOutputs[voiceIndex], numSamples);
+    }
+
+    //the ones nobody fed this block ring on from silence
+    for (int i = 0; i < numAwake; ++i)
+    {
+        auto& resonator = resonators[awakeNotes[i]];
+
+        if (! resonator.isFed && ! resonator.isInputClear)
+        {
+            inputs.getUnchecked (awakeNotes[i])->clear();
+            resonator.isInputClear = true;
+        }
+    }
+
+    if (numAwake == 0)
+        return;
+
+    filters.mixVoices (output, startSample, numSamples, inputs, outputs, awakeNotes, numAwake);
+
+    //whatever wasn't fed and has rung down goes back to sleep
+    auto sleepThreshold = sleepLevel / (1.0f + filters.getTargetQ());
+
+    for (int i = numAwake; --i >= 0;)
+    {
+        auto note = awakeNotes[i];
+        auto& resonator = resonators[note];
+
+        if (! resonator.isFed && filters.getStateLevel (note) < sleepThreshold)
+        {
+            sleep (note);
+            awakeNotes[i] = awakeNotes[--numAwake];
+        }
+
+        resonator.isFed = false;
+    }
+}
@@ -0,0 +1,90 @@
+/*
+    File: ResonatorBank.h
+    Description: The resonator mode's filters: one band-pass per MIDI note, shared by every voice
+    that plays the note. The voices only render enveloped noise; the mix routes each voice into
+    its note's resonator, which was tuned when the bank was prepared and keeps its state from one
+    note to the next. Starting a note is then just a gain change, and a repeated note rings on
+    from where the last one left it, as a struck string would.
+
+    Resonators are woken by the first voice that feeds them and put back to sleep once they have
+    had no input and rung down below the noise floor, so only the ones actually sounding cost
+    anything. The awake ones are filtered side by side by a VoiceFilterBank.
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParallelSynthesiser.h"
+#include "SynthParameters.h"
+#include "VoiceFilterBank.h"
+
+//==============================================================================
+class ResonatorBank   : public ParallelSynthesiser::VoiceMixer
+{
+public:
+    static constexpr int numResonators = 128;
+
+    //routing for voice slots 0 to voiceCapacity - 1 is allocated up front
+    explicit ResonatorBank (int voiceCapacity);
+    ~ResonatorBank();
+
+    //sizes the input buffers and tunes every resonator. call with the synth's lock held, never
+    //from the audio thread
+    void prepare (double sampleRate, int maximumBlockSize);
+
+    //the resonators read Q from here on the audio thread; set before the bank is first used
+    void setParameters (const SynthParameters& newParameters) noexcept     { filters.setParameters (newParameters); }
+
+    //audio thread, between blocks. either way every resonator starts out asleep and silent
+    void setEnabled (bool shouldBeEnabled) noexcept;
+    bool isEnabled() const noexcept                                         { return enabled; }
+
+    //called by a voice when it starts a note: the voice feeds that note's resonator from now on
+    void startVoice (int voiceIndex, int midiNoteNumber) noexcept;
+
+    //how many resonators were filtered in the last block
+    int getNumAwake() const noexcept                                        { return numAwake; }
+
+    //ParallelSynthesiser::VoiceMixer. sums each voice into its note's resonator, filters every
+    //awake resonator and pans it into the output as the voices feeding it say
+    void mixVoices (AudioBuffer<float>& output, int startSample, int numSamples,
+                    const OwnedArray<AudioBuffer<float>>& voiceBuffers,
+                    const ParallelSynthesiser::VoiceOutput* voiceOutputs,
+                    const int* voiceIndices, int numVoices) noexcept override;
+
+    //awake resonators keep sounding after the voices feeding them have stopped
+    bool isRinging() const noexcept override                                { return numAwake > 0; }
+
+private:
+    static constexpr int maxChannels = ParallelSynthesiser::VoiceOutput::maxChannels;
+
+    void feed (int note, const AudioBuffer<float>& voiceBuffer,
+               const ParallelSynthesiser::VoiceOutput& voiceOutput, int numSamples) noexcept;
+    void sleep (int note) noexcept;
+
+    struct Resonator
+    {
+        double frequency = 0.0;
+        bool isAwake = false;
+        bool isFed = false;             //by at least one voice in the current block
+        bool isInputClear = true;       //the input buffer holds silence
+    };
+
+    //the resonators' own filter bank, one slot per note
+    VoiceFilterBank filters { numResonators };
+    Resonator resonators[numResonators];
+
+    //each resonator's input for the current block, and how it is panned; only the channels its
+    //VoiceOutput says it has are filtered
+    OwnedArray<AudioBuffer<float>> inputs;
+    ParallelSynthesiser::VoiceOutput outputs[numResonators];
+
+    int voiceCapacity;
+    HeapBlock<int> voiceNotes;          //the note each voice slot is feeding
+    int awakeNotes[numResonators];
+    int numAwake = 0;
+    int preparedBlockSize = 0;
+    bool enabled = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResonatorBank)
+};
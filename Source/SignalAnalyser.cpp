@@ -0,0 +1,255 @@
+/*
+    File: SignalAnalyser.cpp
+    Description: See SignalAnalyser.h
+*/
+
+#include "SignalAnalyser.h"
+
+SignalAnalyser::SignalAnalyser()
+    : Thread ("Signal analyser")
+{
+    ring.allocate ((size_t) ringSize, true);
+    history.allocate ((size_t) fftSize, true);
+    fftData.allocate ((size_t) fftSize * 2, true);
+
+    std::fill (std::begin (spectrumLevels), std::end (spectrumLevels), (float) minimumDecibels);
+
+    setOpaque (true);
+
+    //well below the voice render threads; a late frame only means a late repaint
+    startThread (3);
+    startTimerHz (frameRateHz);
+}
+
+SignalAnalyser::~SignalAnalyser()
+{
+    stopTimer();
+    stopThread (1000);
+}
+
+//==============================================================================
+void SignalAnalyser::pushSamples (const AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    auto numChannels = buffer.getNumChannels();
+
+    if (numChannels == 0 || numSamples <= 0)
+        return;
+
+    int start1, size1, start2, size2;
+    ringFifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+
+    auto scale = 1.0f / (float) numChannels;
+
+    auto mixDown = [&] (int ringStart, int bufferStart, int count)
+    {
+        auto* destination = ring + ringStart;
+        FloatVectorOperations::copyWithMultiply (destination, buffer.getReadPointer (0, bufferStart), scale, count);
+
+        for (int channel = 1; channel < numChannels; ++channel)
+            FloatVectorOperations::addWithMultiply (destination, buffer.getReadPointer (channel, bufferStart), scale, count);
+    };
+
+    if (size1 > 0)
+        mixDown (start1, startSample, size1);
+
+    if (size2 > 0)
+        mixDown (start2, startSample + size1, size2);
+
+    ringFifo.finishedWrite (size1 + size2);
+}
+
+//==============================================================================
+void SignalAnalyser::run()
+{
+    while (! threadShouldExit())
+    {
+        //nothing new while the device is stopped, so the last frame stays up
+        if (readRing())
+        {
+            buildSpectrum (builtSpectrum);
+            buildScope (builtScope);
+
+            {
+                const SpinLock::ScopedLockType sl (frameLock);
+                readySpectrum.swapWithPath (builtSpectrum);
+                readyScope.swapWithPath (builtScope);
+            }
+
+            isFrameReady = true;
+        }
+
+        wait (1000 / frameRateHz);
+    }
+}
+
+bool SignalAnalyser::readRing() noexcept
+{
+    auto numReady = ringFifo.getNumReady();
+
+    if (numReady == 0)
+        return false;
+
+    //only the latest fftSize samples are ever looked at
+    if (numReady > fftSize)
+    {
+        ringFifo.finishedRead (numReady - fftSize);
+        numReady = fftSize;
+    }
+
+    int start1, size1, start2, size2;
+    ringFifo.prepareToRead (numReady, start1, size1, start2, size2);
+
+    auto numKept = fftSize - numReady;
+    std::memmove (history.get(), history + numReady, (size_t) numKept * sizeof (float));
+    FloatVectorOperations::copy (history + numKept, ring + start1, size1);
+    FloatVectorOperations::copy (history + numKept + size1, ring + start2, size2);
+
+    ringFifo.finishedRead (size1 + size2);
+    return true;
+}
+
+void SignalAnalyser::buildSpectrum (Path& path)
+{
+    FloatVectorOperations::copy (fftData, history, fftSize);
+    FloatVectorOperations::clear (fftData + fftSize, fftSize);
+    window.multiplyWithWindowingTable (fftData, (size_t) fftSize);
+    fft.performFrequencyOnlyForwardTransform (fftData);
+
+    //the window is normalised, so a full-scale sine peaks at fftSize / 2
+    auto magnitudeScale = 2.0f / (float) fftSize;
+    auto nyquist = (float) sampleRate.load() * 0.5f;
+    auto binsPerHz = (float) fftSize / (2.0f * nyquist);
+    auto lastBin = fftSize / 2;
+
+    //log-spaced points; where a point spans several bins it shows the loudest, below that it
+    //interpolates between the two nearest
+    auto getFrequency = [&] (int point)
+    {
+        return minimumFrequency * std::pow (nyquist / minimumFrequency, (float) point / (float) (numSpectrumPoints - 1));
+    };
+
+    path.clear();
+
+    for (int point = 0; point < numSpectrumPoints; ++point)
+    {
+        auto lowBin = getFrequency (point) * binsPerHz;
+        auto highBin = getFrequency (point + 1) * binsPerHz;
+        float magnitude;
+
+        if (highBin - lowBin < 1.0f)
+        {
+            auto bin = jmin (lastBin - 1, (int) lowBin);
+            auto fraction = jlimit (0.0f, 1.0f, lowBin - (float) bin);
+            magnitude = fftData[bin] + fraction * (fftData[bin + 1] - fftData[bin]);
+        }
+        else
+        {
+            auto firstBin = jmin (lastBin, (int) std::ceil (lowBin));
+            auto endBin = jlimit (firstBin + 1, lastBin + 1, (int) highBin + 1);
+            magnitude = FloatVectorOperations::findMaximum (fftData + firstBin, endBin - firstBin);
+        }
+
+        //rises at once, falls away slowly, so the peaks can be read
+        auto level = jmax ((float) minimumDecibels, Decibels::gainToDecibels (magnitude * magnitudeScale, (float) minimumDecibels));
+        spectrumLevels[point] = jmax (level, spectrumLevels[point] - fallDecibelsPerFrame);
+
+        auto x = (float) point / (float) (numSpectrumPoints - 1);
+        auto y = spectrumLevels[point] / minimumDecibels;
+
+        if (point == 0)
+            path.startNewSubPath (x, y);
+        else
+            path.lineTo (x, y);
+    }
+}
+
+void SignalAnalyser::buildScope (Path& path) const
+{
+    //starts on the latest rising zero crossing that still leaves a full trace after it, so a
+    //steady tone stands still
+    auto start = fftSize - scopeSize;
+
+    for (auto i = start; i > 0; --i)
+    {
+        if (history[i - 1] < 0.0f && history[i] >= 0.0f)
+        {
+            start = i;
+            break;
+        }
+    }
+
+    path.clear();
+
+    for (int i = 0; i < scopeSize; ++i)
+    {
+        auto x = (float) i / (float) (scopeSize - 1);
+        auto y = 0.5f - 0.5f * jlimit (-1.0f, 1.0f, history[start + i]);
+
+        if (i == 0)
+            path.startNewSubPath (x, y);
+        else
+            path.lineTo (x, y);
+    }
+}
+
+//==============================================================================
+void SignalAnalyser::timerCallback()
+{
+    if (! isFrameReady.exchange (false))
+        return;
+
+    {
+        const SpinLock::ScopedLockType sl (frameLock);
+        shownSpectrum.swapWithPath (readySpectrum);
+        shownScope.swapWithPath (readyScope);
+    }
+
+    repaint();
+}
+
+float SignalAnalyser::getFrequencyPosition (float frequency) const noexcept
+{
+    auto nyquist = (float) sampleRate.load() * 0.5f;
+    return std::log (frequency / minimumFrequency) / std::log (nyquist / minimumFrequency);
+}
+
+void SignalAnalyser::paint (Graphics& g)
+{
+    g.fillAll (Colours::black);
+
+    auto area = getLocalBounds().reduced (4).toFloat();
+    auto spectrumArea = area.removeFromLeft (area.getWidth() * 0.65f);
+    auto scopeArea = area.withTrimmedLeft (8.0f);
+
+    //a line every 20 dB and at each decade
+    g.setColour (Colours::white.withAlpha (0.15f));
+    g.setFont (11.0f);
+
+    for (auto decibels = -20.0f; decibels > minimumDecibels; decibels -= 20.0f)
+        g.drawHorizontalLine (roundToInt (spectrumArea.getY() + spectrumArea.getHeight() * decibels / minimumDecibels),
+                              spectrumArea.getX(), spectrumArea.getRight());
+
+    for (auto frequency : { 100.0f, 1000.0f, 10000.0f })
+    {
+        auto x = spectrumArea.getX() + spectrumArea.getWidth() * getFrequencyPosition (frequency);
+
+        if (x < spectrumArea.getRight())
+        {
+            g.drawVerticalLine (roundToInt (x), spectrumArea.getY(), spectrumArea.getBottom());
+            g.drawText (frequency < 1000.0f ? String ((int) frequency) : String ((int) frequency / 1000) + "k",
+                        Rectangle<float> (x + 2.0f, spectrumArea.getBottom() - 14.0f, 30.0f, 12.0f),
+                        Justification::centredLeft, false);
+        }
+    }
+
+    g.drawHorizontalLine (roundToInt (scopeArea.getCentreY()), scopeArea.getX(), scopeArea.getRight());
+
+    //the paths are in a unit square; stretching them is all the painting costs
+    auto toArea = [] (Rectangle<float> r) { return AffineTransform::scale (r.getWidth(), r.getHeight()).translated (r.getX(), r.getY()); };
+
+    g.setColour (Colours::lightgreen);
+    g.strokePath (shownSpectrum, PathStrokeType (1.5f), toArea (spectrumArea));
+
+    g.setColour (Colours::lightskyblue);
+    g.strokePath (shownScope, PathStrokeType (1.0f), toArea (scopeArea));
+}
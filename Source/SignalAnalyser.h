@@ -0,0 +1,79 @@
+/*
+    File: SignalAnalyser.h
+    Description: A spectrum analyser and oscilloscope of the synth's output, for watching the band
+    move while tuning Q. The audio thread does nothing but copy each block, mixed down to mono,
+    into a wait-free single-producer ring. A background thread drains the ring, windows and
+    transforms the latest samples and builds both traces as paths in a unit square; the component
+    only scales and strokes them, and repaints at most at the display rate, when a new frame is
+    ready.
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class SignalAnalyser   : public Component,
+                         private Thread,
+                         private Timer
+{
+public:
+    static constexpr int fftOrder = 12;
+    static constexpr int fftSize = 1 << fftOrder;       //samples per transform, about 85 ms at 48 kHz
+    static constexpr int scopeSize = 1024;              //samples across the scope
+    static constexpr int frameRateHz = 60;
+
+    SignalAnalyser();
+    ~SignalAnalyser();
+
+    //==============================================================================
+    //any thread; sets the frequency scale
+    void setSampleRate (double newSampleRate) noexcept  { sampleRate = newSampleRate; }
+
+    //audio thread. wait-free and never allocates: averages the block's channels into the ring.
+    //if the analysis thread has fallen behind, whatever doesn't fit is dropped
+    void pushSamples (const AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+    //==============================================================================
+    void paint (Graphics& g) override;
+
+private:
+    static constexpr int ringSize = 1 << 15;
+    static constexpr int numSpectrumPoints = 256;
+    static constexpr float minimumDecibels = -100.0f;
+    static constexpr float minimumFrequency = 20.0f;
+    static constexpr float fallDecibelsPerFrame = 1.5f;
+
+    //analysis thread
+    void run() override;
+    bool readRing() noexcept;
+    void buildSpectrum (Path& path);
+    void buildScope (Path& path) const;
+
+    //message thread
+    void timerCallback() override;
+    float getFrequencyPosition (float frequency) const noexcept;
+
+    //audio side
+    HeapBlock<float> ring;
+    AbstractFifo ringFifo { ringSize };
+    std::atomic<double> sampleRate { 44100.0 };
+
+    //analysis side
+    dsp::FFT fft { fftOrder };
+    dsp::WindowingFunction<float> window { (size_t) fftSize, dsp::WindowingFunction<float>::hann };
+    HeapBlock<float> history, fftData;
+    float spectrumLevels[numSpectrumPoints];
+    Path builtSpectrum, builtScope;
+
+    //handed from the analysis thread to the message thread by swapping, so neither allocates
+    //under the lock
+    SpinLock frameLock;
+    Path readySpectrum, readyScope;
+    std::atomic<bool> isFrameReady { false };
+
+    //message side
+    Path shownSpectrum, shownScope;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SignalAnalyser)
+};
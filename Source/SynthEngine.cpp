@@ -0,0 +1,1015 @@
+/*
+    File: SynthEngine.cpp
+    Description: White noise voices band-passed at the frequency of the MIDI note they play,
+    plus the AudioSource that owns the voices and feeds them MIDI. A voice renders and filters a
+    single channel; the synth pans it into the output when it mixes the voices.
+*/
+
+#include "SynthEngine.h"
+
+//==============================================================================
+SynthSound::SynthSound(){}
+
+bool SynthSound::appliesToNote( int )    { return true; }
+bool SynthSound::appliesToChannel( int ) { return true; }
+
+
+//==============================================================================
+namespace
+{
+    //a fading voice whose output stays below this, once the (1 + Q) makeup gain is applied, is
+    //ended early: about -90 dB, one step of 16-bit audio
+    constexpr float silenceLevel = 3.0e-5f;
+}
+
+SynthVoice::SynthVoice()
+    {
+        spec.sampleRate = 44100.0;
+        spec.maximumBlockSize = 0;
+        spec.numChannels = CHANNELS;
+        
+        //the owner splits the voices' noise into separate streams with setNoiseSeed
+        setNoiseSeed( 0, 0 );
+    }
+
+//sizes the scratch buffer and filter state; the only place a voice allocates
+void SynthVoice::prepareToPlay( int samplesPerBlockExpected, int numChannels, double sampleRate )
+{
+    samplesPerBlock = samplesPerBlockExpected;
+    
+    spec.sampleRate = sampleRate;
+    spec.maximumBlockSize = (uint32) samplesPerBlockExpected;
+    spec.numChannels = (uint32) numChannels;
+    
+    bufferBuffer.setSize( numChannels, samplesPerBlockExpected );
+    bufferBuffer.clear();
+    envelopeBuffer.setSize( 1, samplesPerBlockExpected );
+    
+    filter.prepare( sampleRate );
+    smoothedQ.reset( sampleRate, SynthParameters::getDefinition( SynthParameters::q ).rampSeconds );
+    envelope.setSampleRate( sampleRate );
+    noise.setSampleRate( sampleRate );
+    secondNoise.setSampleRate( sampleRate );
+}
+
+void SynthVoice::setOversamplingFactor( int factor )
+{
+    noiseGain = std::sqrt( (float) jmax( 1, factor ) );
+}
+
+void SynthVoice::setEnvelopeParameters( const EnvelopeGenerator::Parameters& newParameters )
+{
+    envelope.setParameters( newParameters );
+}
+
+void SynthVoice::setParameters( const SynthParameters& newParameters )
+{
+    parameters = &newParameters;
+}
+
+void SynthVoice::setFilterBank( VoiceFilterBank* newBank, int voiceIndex )
+{
+    filterBank = newBank;
+    filterBankIndex = voiceIndex;
+}
+
+void SynthVoice::setResonatorBank( ResonatorBank* newBank )
+{
+    resonatorBank = newBank;
+}
+
+bool SynthVoice::isFilteredByMixer() const noexcept
+{
+    return (filterBank != nullptr && filterBank->isEnabled())
+        || (resonatorBank != nullptr && resonatorBank->isEnabled());
+}
+
+void SynthVoice::setPanLaw( PanLaw newLaw )
+{
+    panLaw = newLaw;
+    updatePanGains();
+}
+
+void SynthVoice::setFilterTopology( VoiceFilter::Topology newTopology )
+{
+    filter.setTopology( newTopology );
+}
+
+void SynthVoice::setNoiseSeed( uint32 seed, int streamNumber )
+{
+    //each voice needs its own streams or stacked notes would be correlated
+    noise.setSeed( seed, (uint32) streamNumber * 2 );
+    secondNoise.setSeed( seed, (uint32) streamNumber * 2 + 1 );
+}
+
+void SynthVoice::setNoiseColour( NoiseGenerator::Colour newColour )
+{
+    noise.setColour( newColour );
+    secondNoise.setColour( newColour );
+}
+
+void SynthVoice::setParts( const SynthPart* newParts )
+{
+    parts = newParts;
+    part = nullptr;
+}
+
+int SynthVoice::getPartIndex() const noexcept
+{
+    return part != nullptr ? (int) (part - parts) : -1;
+}
+
+const SynthParameters* SynthVoice::getPatchParameters() const noexcept
+{
+    return part != nullptr ? &part->parameters : parameters;
+}
+
+void SynthVoice::setModulation( const ModulationMatrix* newModulation )
+{
+    modulation = newModulation;
+}
+
+void SynthVoice::setVelocityCurve( const VelocityCurve* newCurve )
+{
+    velocityCurve = newCurve;
+}
+
+void SynthVoice::setControlInterval( int numSamples )
+{
+    controlInterval = jmax( 1, numSamples );
+}
+
+void SynthVoice::updateModulation() noexcept
+{
+    auto newCutoffRatio = 1.0f, newQRatio = 1.0f;
+    targetLevelGain = 1.0f;
+    
+    if( modulation != nullptr && modulation->isActive() )
+    {
+        auto offsets = modulation->evaluate( midiChannel, noteNumber );
+        newCutoffRatio = std::exp2( offsets.cutoffSemitones / 12.0f );
+        newQRatio = std::exp2( offsets.qOctaves );
+        targetLevelGain = Decibels::decibelsToGain( offsets.levelDecibels );
+    }
+    
+    //the output stage makes up for the patch's Q; a voice whose own filter runs at another Q
+    //makes up the difference itself, so narrowing the band doesn't also quieten the note
+    if( ( newQRatio != 1.0f || velocityQRatio != 1.0f ) && ! isFilteredByMixer() )
+    {
+        auto& qRange = SynthParameters::getDefinition( SynthParameters::q );
+        auto patchQ = getTargetQ();
+        auto voiceQ = jlimit( qRange.minimum, qRange.maximum, patchQ * newQRatio * velocityQRatio );
+        targetLevelGain *= (1.0f + voiceQ) / (1.0f + patchQ);
+    }
+    
+    if( newCutoffRatio != cutoffRatio || newQRatio != qRatio )
+    {
+        cutoffRatio = newCutoffRatio;
+        qRatio = newQRatio;
+        isModulationMoving = true;
+    }
+}
+
+void SynthVoice::applyLevelModulation( float* gains, int numSamples ) noexcept
+{
+    //a new level is ramped to over one control interval, as the filter is
+    auto rampLength = levelGain != targetLevelGain ? jmin( controlInterval, numSamples ) : 0;
+    
+    if( rampLength > 0 )
+    {
+        auto step = (targetLevelGain - levelGain) / (float) rampLength;
+        
+        for( int i = 0; i < rampLength; ++i )
+            gains[i] *= levelGain + step * (float) (i + 1);
+        
+        levelGain = targetLevelGain;
+    }
+    
+    if( levelGain != 1.0f )
+        FloatVectorOperations::multiply( gains + rampLength, levelGain, numSamples - rampLength );
+}
+
+void SynthVoice::setStereoNoise( bool shouldUseStereoNoise )
+{
+    //the second channel's filter has been idle, so it starts from silence
+    if( shouldUseStereoNoise && ! stereoNoise )
+        filter.reset( 1 );
+    
+    stereoNoise = shouldUseStereoNoise;
+}
+
+int SynthVoice::getNumRenderedChannels() const noexcept
+{
+    return stereoNoise && bufferBuffer.getNumChannels() > 1 ? 2 : 1;
+}
+
+void SynthVoice::getOutput( ParallelSynthesiser::VoiceOutput& output ) const noexcept
+{
+    output.numChannels = getNumRenderedChannels();
+    
+    //a part's makeup can't wait for the output stage, which serves every part at once
+    auto gain = part != nullptr ? part->gain : 1.0f;
+    
+    for( int i = 0; i < ParallelSynthesiser::VoiceOutput::maxChannels; ++i )
+        output.gains[i] = panGains[i] * gain;
+}
+
+void SynthVoice::updatePanGains() noexcept
+{
+    switch( panLaw )
+    {
+        case PanLaw::constantPower:
+        {
+            auto angle = (pan + 1.0f) * MathConstants<float>::pi * 0.25f;
+            panGains[0] = std::cos( angle );
+            panGains[1] = std::sin( angle );
+            break;
+        }
+            
+        case PanLaw::linear:
+            panGains[0] = 0.5f * (1.0f - pan);
+            panGains[1] = 0.5f * (1.0f + pan);
+            break;
+            
+        case PanLaw::balanced:
+        default:
+            panGains[0] = jmin( 1.0f, 1.0f - pan );
+            panGains[1] = jmin( 1.0f, 1.0f + pan );
+            break;
+    }
+}
+
+
+bool SynthVoice::canPlaySound (SynthesiserSound* sound){
+        return dynamic_cast<SynthSound*> (sound) != nullptr;
+}
+
+void SynthVoice::startNote (int midiNoteNumber, float velocity,
+                            SynthesiserSound*, int /*currentPitchWheelPosition*/) {
+    
+    //the channel picks the part and the controllers the note follows
+    midiChannel = 0;
+    noteNumber = midiNoteNumber;
+    
+    for( int channel = 1; channel <= ParallelSynthesiser::numMidiChannels && midiChannel == 0; ++channel )
+        if( isPlayingChannel( channel ) )
+            midiChannel = channel;
+    
+    //a multi-timbral note takes its whole patch from its channel's part
+    if( parts != nullptr )
+    {
+        part = midiChannel > 0 ? parts + midiChannel - 1 : nullptr;
+        
+        if( part != nullptr )
+        {
+            envelope.setParameters( part->envelope );
+            filter.setTopology( part->topology );
+            setNoiseColour( part->noiseColour );
+        }
+    }
+    
+    //with a bank doing the filtering the voice's own filter stays idle, and a note on a
+    //resonator is nothing more than the envelope starting
+    auto ownsFilter = ! isFilteredByMixer();
+    
+    if( ownsFilter )
+        filter.reset();
+    
+    envelope.noteOn();
+    
+    //the patch's curve turns the velocity into the note's level, with full velocity at the old
+    //fixed level, and the same curved velocity scales the Q
+    auto* patch = getPatchParameters();
+    auto curvedVelocity = velocity;
+    auto velocityQ = 0.0f;
+    
+    if( patch != nullptr )
+    {
+        auto shape = (VelocityCurve::Shape) roundToInt( patch->getTargetValue( SynthParameters::velocityCurve ) );
+        
+        if( velocityCurve != nullptr )
+            curvedVelocity = velocityCurve->getGain( shape, velocity );
+        
+        velocityQ = patch->getTargetValue( SynthParameters::velocityQ );
+    }
+    
+    level = 0.5 * curvedVelocity;
+    velocityQRatio = velocityQ != 0.0f ? std::exp2( velocityQ * curvedVelocity ) : 1.0f;
+    isOn = true;
+    
+    frequency = MidiMessage::getMidiNoteInHertz (midiNoteNumber);
+    
+    //the note starts wherever the controllers already are, without gliding there
+    updateModulation();
+    levelGain = targetLevelGain;
+    isModulationMoving = false;
+    
+    //full spread puts the lowest note hard left and the highest hard right
+    auto spread = patch != nullptr ? patch->getTargetValue( SynthParameters::spread ) : 0.0f;
+    pan = spread * jlimit( -1.0f, 1.0f, (float) (midiNoteNumber - 64) / 64.0f );
+    updatePanGains();
+    
+    //kept in step whichever engine is on, so switching never leaves the bank on a stale note
+    if( filterBank != nullptr )
+        filterBank->startVoice( filterBankIndex, frequency );
+    
+    if( resonatorBank != nullptr )
+        resonatorBank->startVoice( filterBankIndex, midiNoteNumber );
+    
+    //a new note starts at the current Q rather than gliding from the previous note's
+    if( ownsFilter )
+    {
+        smoothedQ.setCurrentAndTargetValue( getTargetQ() );
+        updateFilter();
+    }
+}
+void SynthVoice::stopNote (float /*velocity*/, bool allowTailOff){
+    
+    if (allowTailOff)
+    {
+        envelope.noteOff();
+    }
+    else
+    {
+        endNote();
+    }
+}
+
+void SynthVoice::endNote()
+{
+    clearCurrentNote();
+    isOn = false;
+    envelope.reset();
+    
+    filter.reset();
+}
+//the modulation matrix keeps every channel's controllers, and the voice reads them at its next render
+void SynthVoice::pitchWheelMoved (int){}
+void SynthVoice::controllerMoved (int, int){}
+
+void SynthVoice::updateFilter( int numSamplesToRamp ){
+
+    //only runs the trig when the note, Q, modulation, sample rate or topology changed since the last call
+    auto& qRange = SynthParameters::getDefinition( SynthParameters::q );
+    auto q = jlimit( qRange.minimum, qRange.maximum, smoothedQ.getCurrentValue() * qRatio * velocityQRatio );
+    
+    if( numSamplesToRamp > 0 )
+        filter.updateRamped( frequency * cutoffRatio, q, numSamplesToRamp );
+    else
+        filter.update( frequency * cutoffRatio, q );
+
+}
+float SynthVoice::getTargetQ() const
+{
+    auto* patch = getPatchParameters();
+    jassert( patch != nullptr );
+    
+    return patch != nullptr ? patch->getTargetValue( SynthParameters::q )
+                            : SynthParameters::getDefinition( SynthParameters::q ).defaultValue;
+}
+
+float SynthVoice::getCurrentLevel() const noexcept
+{
+    return isOn ? envelope.getCurrentLevel() * (float) level * levelGain : 0.0f;
+}
+
+float SynthVoice::getPeakLevel( int numChannels, int numSamples ) const noexcept
+{
+    auto peak = 0.0f;
+    
+    for( auto i = 0; i < numChannels; ++i )
+        peak = jmax( peak, bufferBuffer.getMagnitude( i, 0, numSamples ) );
+    
+    return peak;
+}
+
+float SynthVoice::getSilenceThreshold() const noexcept
+{
+    return silenceLevel / (1.0f + getTargetQ());
+}
+
+void SynthVoice::renderNextBlock (AudioSampleBuffer& outputBuffer, int startSample, int numSamples)
+{
+    if( isOn )
+    {
+        //the scratch buffer is sized by SynthAudioSource before the callback, never here
+        jassert( numSamples <= bufferBuffer.getNumSamples() );
+        jassert( outputBuffer.getNumChannels() <= bufferBuffer.getNumChannels() );
+        
+        numSamples = jmin( numSamples, bufferBuffer.getNumSamples() );
+        
+        //one channel, or one per independent noise stream; the mix pans them
+        auto numChannels = jmin( outputBuffer.getNumChannels(), getNumRenderedChannels() );
+        auto* gains = envelopeBuffer.getWritePointer( 0 );
+        
+        //the envelope reports a short count on the block its release finishes in
+        auto numToRender = envelope.getNextBlock( gains, numSamples );
+        
+        //the synth splits its blocks at MIDI events, so the controllers hold still for a render
+        updateModulation();
+        applyLevelModulation( gains, numToRender );
+        
+        for( auto i = 0; i < numChannels; ++i )
+        {
+            auto* excitation = bufferBuffer.getWritePointer( i );
+            
+            (i == 0 ? noise : secondNoise).process( excitation, numToRender, (float) level * noiseGain, 1.0f );
+            FloatVectorOperations::multiply( excitation, gains, numToRender );
+            FloatVectorOperations::clear( excitation + numToRender, numSamples - numToRender );
+        }
+        
+        if (numToRender < numSamples)
+            endNote();
+        
+        //a bank filters every voice's excitation together once they have all rendered
+        if( isFilteredByMixer() )
+        {
+            //so the voice's own filters pick up cleanly if the engine is switched back
+            filter.reset();
+            
+            smoothedQ.setCurrentAndTargetValue( getTargetQ() );
+            
+            for( auto i = 0; i < numChannels; ++i )
+                outputBuffer.addFrom( i, startSample, bufferBuffer, i, 0, numSamples );
+            
+            //the SIMD bank's state says how loud this voice's filter rang in the last block; a
+            //resonator is shared, so there only the voice's own excitation counts
+            if( isOn && envelope.isFadingOut() )
+            {
+                auto peak = filterBank != nullptr && filterBank->isEnabled() ? filterBank->getStateLevel( filterBankIndex )
+                                                                              : getPeakLevel( numChannels, numSamples );
+                
+                if( peak < getSilenceThreshold() )
+                    endNote();
+            }
+            
+            return;
+        }
+        
+        smoothedQ.setTargetValue( getTargetQ() );
+        
+        //a steady filter runs the whole block at once. while Q glides or the modulation has moved,
+        //the coefficients are recomputed every controlInterval samples and ramped in between, so
+        //neither slider moves nor expressive playing zipper or cost a recompute per sample
+        for (int pos = 0; pos < numSamples;)
+        {
+            auto isMoving = smoothedQ.isSmoothing() || isModulationMoving;
+            auto numThisTime = isMoving ? jmin( controlInterval, numSamples - pos ) : numSamples - pos;
+            smoothedQ.skip( numThisTime );
+            isModulationMoving = false;
+            
+            updateFilter( isMoving ? numThisTime : 0 );
+            
+            for( auto i = 0; i < numChannels; ++i )
+                filter.process( i, bufferBuffer.getWritePointer( i, pos ), numThisTime );
+            
+            pos += numThisTime;
+        }
+        
+        //the (1 + Q) makeup gain for the patch's Q is applied once to the whole mix by the output
+        //stage; any modulated or velocity Q on top was made up in the envelope gains
+        for( auto i = numChannels; --i >= 0;)
+            outputBuffer.addFrom( i, startSample, bufferBuffer, i, 0, numSamples );
+        
+        //a released note that has rung down out of hearing stops here instead of running out its
+        //release, so a pile of long tails doesn't keep every voice busy
+        if( isOn && envelope.isFadingOut() && getPeakLevel( numChannels, numSamples ) < getSilenceThreshold() )
+            endNote();
+    }
+}
+
+
+//==============================================================================
+namespace
+{
+    VoiceFilter::Topology getFilterTopology (float filterType) noexcept
+    {
+        return (VoiceFilter::Topology) jlimit ((int) VoiceFilter::Topology::biquad, (int) VoiceFilter::Topology::ladder,
+                                               roundToInt (filterType));
+    }
+    
+    NoiseGenerator::Colour getNoiseColour (float noiseColour) noexcept
+    {
+        return (NoiseGenerator::Colour) jlimit ((int) NoiseGenerator::Colour::white, (int) NoiseGenerator::Colour::blue,
+                                                roundToInt (noiseColour));
+    }
+}
+
+SynthAudioSource::SynthAudioSource (int numVoices)
+    {
+        filterBank.setParameters (parameters);
+        resonatorBank.setParameters (parameters);
+        synth.setMidiObserver (&modulation);
+        
+        for (auto& limit : partVoiceLimits)
+            limit = maxPolyphony;
+        
+        setPolyphony (numVoices);
+        synth.addSound (new SynthSound());
+    }
+    
+    void SynthAudioSource::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
+    {
+        currentSampleRate = sampleRate;
+        synth.setCurrentPlaybackSampleRate (sampleRate * getOversamplingFactor());
+        midiQueue.prepare (sampleRate);
+        parameters.prepare (sampleRate);
+        
+        for (auto& part : parts)
+            part.parameters.prepare (sampleRate);
+        
+        performanceMonitor.setSampleRate (sampleRate);
+        
+        //room for a full queue's worth of events, so a burst never allocates on the audio thread
+        incomingMidi.ensureSize (16 * MidiEventQueue::defaultCapacity);
+        oversampledMidi.ensureSize (16 * MidiEventQueue::defaultCapacity);
+        prepareVoices (samplesPerBlockExpected, CHANNELS);
+    }
+    
+    void SynthAudioSource::prepareVoices (int samplesPerBlockExpected, int numChannels)
+    {
+        //setPolyphony can swap the voices from the message thread
+        const ScopedLock sl (synth.getLock());
+        
+        preparedBlockSize = samplesPerBlockExpected;
+        preparedChannels = numChannels;
+        
+        //everything up to the decimator runs at the oversampled rate. the buffers are sized for
+        //the highest factor whatever the current one, so switching the factor never reallocates
+        auto renderBlockSize = samplesPerBlockExpected * Decimator::maxFactor;
+        
+        synth.prepare (renderBlockSize, numChannels);
+        oversampledBuffer.setSize (numChannels, renderBlockSize);
+        decimator.prepare (oversamplingFactor, samplesPerBlockExpected, numChannels);
+        prepareRenderRate();
+    }
+    
+    //retunes the banks and voices to the current factor's rate. everything was sized by
+    //prepareVoices, so this doesn't allocate; call with the synth's lock held
+    void SynthAudioSource::prepareRenderRate()
+    {
+        auto renderBlockSize = preparedBlockSize * Decimator::maxFactor;
+        auto renderSampleRate = currentSampleRate * oversamplingFactor;
+        
+        filterBank.prepare (renderSampleRate, renderBlockSize);
+        resonatorBank.prepare (renderSampleRate, renderBlockSize);
+        
+        //a prepared synth always starts its noise from the top of its streams, so a render is
+        //the same from one run to the next
+        auto seed = getNoiseSeed();
+        
+        for (auto i = 0; i < synth.getNumVoices(); ++i)
+        {
+            if (auto* voice = dynamic_cast<SynthVoice*> (synth.getVoice (i)))
+            {
+                voice->prepareToPlay (renderBlockSize, preparedChannels, renderSampleRate);
+                voice->setOversamplingFactor (oversamplingFactor);
+                voice->setNoiseSeed (seed, i);
+            }
+        }
+        
+        isDecimatorClear = true;
+    }
+    
+    void SynthAudioSource::setOversamplingFactor (int newFactor)
+    {
+        newFactor = newFactor >= Decimator::maxFactor ? Decimator::maxFactor : newFactor >= 2 ? 2 : 1;
+        
+        int blockSize, numChannels;
+        
+        {
+            const ScopedLock sl (synth.getLock());
+            
+            if (newFactor == oversamplingFactor)
+                return;
+            
+            blockSize = preparedBlockSize;
+            numChannels = preparedChannels;
+        }
+        
+        //built here, off the lock, and swapped in below; the old decimator's filters are freed
+        //when this goes out of scope, after the lock is released
+        Decimator newDecimator;
+        newDecimator.prepare (newFactor, blockSize, numChannels);
+        
+        const ScopedLock sl (synth.getLock());
+        
+        oversamplingFactor = newFactor;
+        
+        if (currentSampleRate > 0.0)
+            synth.setCurrentPlaybackSampleRate (currentSampleRate * newFactor);
+        
+        //the device was re-prepared in between, so the new decimator is the wrong size
+        if (blockSize != preparedBlockSize || numChannels != preparedChannels)
+        {
+            prepareVoices (preparedBlockSize, preparedChannels);
+            return;
+        }
+        
+        decimator.swapWith (newDecimator);
+        
+        if (currentSampleRate > 0.0 && preparedBlockSize > 0)
+            prepareRenderRate();
+    }
+    
+    int SynthAudioSource::getOversamplingFactor() const
+    {
+        const ScopedLock sl (synth.getLock());
+        return oversamplingFactor;
+    }
+    
+    float SynthAudioSource::getLatencyInSamples() const
+    {
+        const ScopedLock sl (synth.getLock());
+        return decimator.getLatencyInSamples();
+    }
+    
+    void SynthAudioSource::setPolyphony (int numVoices)
+    {
+        EnvelopeGenerator::Parameters envelopeParameters;
+        envelopeParameters.attack = parameters.getValue (SynthParameters::attack);
+        envelopeParameters.decay = parameters.getValue (SynthParameters::decay);
+        envelopeParameters.sustain = parameters.getValue (SynthParameters::sustain);
+        envelopeParameters.release = parameters.getValue (SynthParameters::release);
+        
+        int blockSize, numChannels, interval, factor;
+        double sampleRate;
+        
+        {
+            const ScopedLock sl (synth.getLock());
+            blockSize = preparedBlockSize * Decimator::maxFactor;
+            numChannels = preparedChannels;
+            factor = oversamplingFactor;
+            sampleRate = currentSampleRate * oversamplingFactor;
+            interval = getControlInterval() * oversamplingFactor;
+        }
+        
+        //the new voices are fully prepared before the synth swaps them in
+        int voiceIndex = 0;
+        
+        synth.createVoices<SynthVoice> (jlimit (1, maxPolyphony, numVoices), [&] (SynthVoice& voice)
+        {
+            if (blockSize > 0)
+                voice.prepareToPlay (blockSize, numChannels, sampleRate);
+            
+            voice.setOversamplingFactor (factor);
+            voice.setEnvelopeParameters (envelopeParameters);
+            voice.setParameters (parameters);
+            voice.setFilterBank (&filterBank, voiceIndex);
+            voice.setNoiseSeed (getNoiseSeed(), voiceIndex++);
+            voice.setResonatorBank (&resonatorBank);
+            voice.setPanLaw (getPanLaw());
+            voice.setStereoNoise (isStereoNoise());
+            voice.setFilterTopology (getFilterTopology (parameters.getValue (SynthParameters::filterType)));
+            voice.setNoiseColour (getNoiseColour (parameters.getValue (SynthParameters::noiseColour)));
+            voice.setParts (isMultitimbral() ? parts : nullptr);
+            voice.setModulation (&modulation);
+            voice.setVelocityCurve (&velocityCurve);
+            voice.setControlInterval (interval);
+        });
+    }
+    
+    SynthParameters& SynthAudioSource::getPartParameters (int partIndex) noexcept
+    {
+        jassert (isPositiveAndBelow (partIndex, numParts));
+        return parts[jlimit (0, numParts - 1, partIndex)].parameters;
+    }
+    
+    void SynthAudioSource::setPartVoiceLimit (int partIndex, int maxVoices) noexcept
+    {
+        jassert (isPositiveAndBelow (partIndex, numParts));
+        
+        if (isPositiveAndBelow (partIndex, numParts))
+            partVoiceLimits[partIndex] = jlimit (0, maxPolyphony, maxVoices);
+    }
+    
+    int SynthAudioSource::getPartVoiceLimit (int partIndex) const noexcept
+    {
+        return isPositiveAndBelow (partIndex, numParts) ? partVoiceLimits[partIndex].load() : maxPolyphony;
+    }
+    
+    void SynthAudioSource::advanceOutputGain (int numSamples, float& startGain, float& endGain) noexcept
+    {
+        auto& volume = parameters.getSmoothedValue (SynthParameters::volume);
+        auto& q = parameters.getSmoothedValue (SynthParameters::q);
+        
+        //each part's voices carry their own makeup, so in multi-timbral mode the master Q has none
+        auto qScale = voiceMultitimbral ? 0.0f : 1.0f;
+        
+        startGain = volume.getCurrentValue() * (1.0f + qScale * q.getCurrentValue());
+        volume.skip (numSamples);
+        q.skip (numSamples);
+        endGain = volume.getCurrentValue() * (1.0f + qScale * q.getCurrentValue());
+        
+        //the parts' gains step once a block, from where their smoothers have got to
+        if (voiceMultitimbral)
+        {
+            for (auto& part : parts)
+            {
+                part.parameters.getSmoothedValue (SynthParameters::volume).skip (numSamples);
+                part.parameters.getSmoothedValue (SynthParameters::q).skip (numSamples);
+            }
+        }
+    }
+    
+    int SynthAudioSource::getPolyphony() const
+    {
+        return synth.getNumVoices();
+    }
+    
+    void SynthAudioSource::setStealingPolicy (StealingPolicy newPolicy)
+    {
+        synth.setStealingPolicy (newPolicy);
+    }
+    
+    SynthAudioSource::StealingPolicy SynthAudioSource::getStealingPolicy() const
+    {
+        return synth.getStealingPolicy();
+    }
+    
+    SynthAudioSource::FilterEngine SynthAudioSource::getEffectiveFilterEngine() const noexcept
+    {
+        auto topology = getFilterTopology (parameters.getValue (SynthParameters::filterType));
+        return topology == FilterTopology::biquad && ! isMultitimbral() ? getFilterEngine() : FilterEngine::perVoice;
+    }
+    
+    void SynthAudioSource::setRenderOptions (const VoiceRenderScheduler::Options& newOptions)
+    {
+        synth.getScheduler().setOptions (newOptions);
+    }
+    
+    void SynthAudioSource::updateParameters()
+    {
+        parameters.pullChanges();
+        modulation.pullChanges();
+        velocityCurve.pullChanges();
+        
+        //the voices count in oversampled samples
+        auto newSubBlockSize = getMinimumSubBlockSize() * getOversamplingFactor();
+        
+        if (newSubBlockSize != synthSubBlockSize)
+        {
+            synthSubBlockSize = newSubBlockSize;
+            synth.setMinimumRenderingSubdivisionSize (newSubBlockSize, false);
+        }
+        
+        auto newControlInterval = getControlInterval() * getOversamplingFactor();
+        
+        if (newControlInterval != voiceControlInterval)
+        {
+            voiceControlInterval = newControlInterval;
+            
+            const ScopedLock sl (synth.getLock());
+            
+            for (auto i = 0; i < synth.getNumVoices(); ++i)
+                if (auto* voice = dynamic_cast<SynthVoice*> (synth.getVoice (i)))
+                    voice->setControlInterval (newControlInterval);
+        }
+        
+        //a note keeps the patch it started with, so switching modes cuts every note off
+        auto isMulti = isMultitimbral();
+        auto modeChanged = isMulti != voiceMultitimbral;
+        
+        if (modeChanged)
+        {
+            voiceMultitimbral = isMulti;
+            
+            const ScopedLock sl (synth.getLock());
+            
+            synth.allNotesOff (0, false);
+            
+            for (auto i = 0; i < synth.getNumVoices(); ++i)
+                if (auto* voice = dynamic_cast<SynthVoice*> (synth.getVoice (i)))
+                    voice->setParts (isMulti ? parts : nullptr);
+        }
+        
+        for (int i = 0; i < numParts; ++i)
+            synth.setChannelVoiceLimit (i + 1, isMulti ? partVoiceLimits[i].load() : maxPolyphony);
+        
+        if (isMulti)
+            updateParts();
+        
+        auto newTopology = getFilterTopology (parameters.getTargetValue (SynthParameters::filterType));
+        auto engine = newTopology == FilterTopology::biquad && ! isMulti ? getFilterEngine() : FilterEngine::perVoice;
+        auto useBank = engine == FilterEngine::simdBank;
+        auto useResonators = engine == FilterEngine::resonators;
+        
+        if (useBank != filterBank.isEnabled() || useResonators != resonatorBank.isEnabled())
+        {
+            const ScopedLock sl (synth.getLock());
+            
+            filterBank.setEnabled (useBank);
+            resonatorBank.setEnabled (useResonators);
+            synth.setVoiceMixer (useBank ? static_cast<ParallelSynthesiser::VoiceMixer*> (&filterBank)
+                                         : useResonators ? &resonatorBank : nullptr);
+        }
+        
+        EnvelopeGenerator::Parameters newParameters;
+        newParameters.attack = parameters.getTargetValue (SynthParameters::attack);
+        newParameters.decay = parameters.getTargetValue (SynthParameters::decay);
+        newParameters.sustain = parameters.getTargetValue (SynthParameters::sustain);
+        newParameters.release = parameters.getTargetValue (SynthParameters::release);
+        
+        //the voices only recalculate their rates when something actually moved. the parts set
+        //their own, and the master patch is put back when the parts are switched off
+        if (newParameters != voiceEnvelopeParameters || modeChanged)
+        {
+            voiceEnvelopeParameters = newParameters;
+            
+            const ScopedLock sl (synth.getLock());
+            
+            if (! isMulti)
+                for (auto i = 0; i < synth.getNumVoices(); ++i)
+                    if (auto* voice = dynamic_cast<SynthVoice*> (synth.getVoice (i)))
+                        voice->setEnvelopeParameters (newParameters);
+        }
+        
+        auto newPanLaw = getPanLaw();
+        auto newStereoNoise = isStereoNoise();
+        auto newNoiseColour = getNoiseColour (parameters.getTargetValue (SynthParameters::noiseColour));
+        
+        if (newPanLaw != voicePanLaw || newStereoNoise != voiceStereoNoise || newTopology != voiceTopology
+             || newNoiseColour != voiceNoiseColour || modeChanged)
+        {
+            voicePanLaw = newPanLaw;
+            voiceStereoNoise = newStereoNoise;
+            voiceTopology = newTopology;
+            voiceNoiseColour = newNoiseColour;
+            
+            const ScopedLock sl (synth.getLock());
+            
+            for (auto i = 0; i < synth.getNumVoices(); ++i)
+            {
+                if (auto* voice = dynamic_cast<SynthVoice*> (synth.getVoice (i)))
+                {
+                    voice->setPanLaw (newPanLaw);
+                    voice->setStereoNoise (newStereoNoise);
+                    
+                    if (! isMulti)
+                    {
+                        voice->setFilterTopology (newTopology);
+                        voice->setNoiseColour (newNoiseColour);
+                    }
+                }
+            }
+        }
+        
+        auto newNoiseSeed = getNoiseSeed();
+        
+        if (newNoiseSeed != voiceNoiseSeed)
+        {
+            voiceNoiseSeed = newNoiseSeed;
+            
+            const ScopedLock sl (synth.getLock());
+            
+            for (auto i = 0; i < synth.getNumVoices(); ++i)
+                if (auto* voice = dynamic_cast<SynthVoice*> (synth.getVoice (i)))
+                    voice->setNoiseSeed (newNoiseSeed, i);
+        }
+    }
+    
+    void SynthAudioSource::updateParts()
+    {
+        for (int i = 0; i < numParts; ++i)
+        {
+            auto& part = parts[i];
+            auto& partParameters = part.parameters;
+            partParameters.pullChanges();
+            
+            part.gain = partParameters.getSmoothedValue (SynthParameters::volume).getCurrentValue()
+                          * (1.0f + partParameters.getSmoothedValue (SynthParameters::q).getCurrentValue());
+            
+            EnvelopeGenerator::Parameters newEnvelope;
+            newEnvelope.attack = partParameters.getTargetValue (SynthParameters::attack);
+            newEnvelope.decay = partParameters.getTargetValue (SynthParameters::decay);
+            newEnvelope.sustain = partParameters.getTargetValue (SynthParameters::sustain);
+            newEnvelope.release = partParameters.getTargetValue (SynthParameters::release);
+            
+            auto newTopology = getFilterTopology (partParameters.getTargetValue (SynthParameters::filterType));
+            auto newNoiseColour = getNoiseColour (partParameters.getTargetValue (SynthParameters::noiseColour));
+            
+            //new notes read the part when they start; the ones already sounding are told here
+            if (newEnvelope != part.envelope || newTopology != part.topology || newNoiseColour != part.noiseColour)
+            {
+                part.envelope = newEnvelope;
+                part.topology = newTopology;
+                part.noiseColour = newNoiseColour;
+                
+                const ScopedLock sl (synth.getLock());
+                
+                for (auto v = 0; v < synth.getNumVoices(); ++v)
+                {
+                    auto* voice = dynamic_cast<SynthVoice*> (synth.getVoice (v));
+                    
+                    if (voice != nullptr && voice->isVoiceActive() && voice->getPartIndex() == i)
+                    {
+                        voice->setEnvelopeParameters (newEnvelope);
+                        voice->setFilterTopology (newTopology);
+                        voice->setNoiseColour (newNoiseColour);
+                    }
+                }
+            }
+        }
+    }
+    
+    void SynthAudioSource::releaseResources(){}
+    
+    void SynthAudioSource::ensurePrepared (int numChannels, int numSamples)
+    {
+        //a device that changes its block size or channel count without a new prepareToPlay
+        //gets one resize here; everything after it must stay allocation-free
+        if (numSamples > preparedBlockSize || numChannels != preparedChannels)
+            prepareVoices (jmax (numSamples, preparedBlockSize), numChannels);
+    }
+    
+    void SynthAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill)
+    {
+        auto startCycles = PerformanceMonitor::getCycles();
+        ensurePrepared (bufferToFill.buffer->getNumChannels(), bufferToFill.numSamples);
+        
+        const ScopedAllocationGuard noAllocation;
+        
+        bufferToFill.clearActiveBufferRegion();
+        updateParameters();
+        
+        incomingMidi.clear();
+        midiQueue.removeNextBlockOfMessages (incomingMidi, bufferToFill.startSample, bufferToFill.numSamples);
+        
+        renderSynth (*bufferToFill.buffer, incomingMidi,
+                     bufferToFill.startSample, bufferToFill.numSamples, startCycles);
+    }
+
+    void SynthAudioSource::renderNextBlock (AudioBuffer<float>& buffer, const MidiBuffer& midi,
+                                            int startSample, int numSamples)
+    {
+        auto startCycles = PerformanceMonitor::getCycles();
+        ensurePrepared (buffer.getNumChannels(), numSamples);
+        
+        const ScopedAllocationGuard noAllocation;
+        
+        buffer.clear (startSample, numSamples);
+        updateParameters();
+        renderSynth (buffer, midi, startSample, numSamples, startCycles);
+    }
+    
+    void SynthAudioSource::renderSynth (AudioBuffer<float>& buffer, const MidiBuffer& midi,
+                                        int startSample, int numSamples, uint64 startCycles)
+    {
+        //flush-to-zero for the whole render, so decaying envelopes and filter states never fall
+        //into the slow denormal range; the worker threads set their own
+        const ScopedNoDenormals noDenormals;
+        
+        synth.resetVoiceTimings();
+        
+        {
+            //setOversamplingFactor swaps the rate and buffers from the message thread
+            const ScopedLock sl (synth.getLock());
+            
+            if (oversamplingFactor > 1)
+                renderOversampled (buffer, midi, startSample, numSamples);
+            
+            //nothing sounding and no events: the buffer is already clear, so there is nothing to do
+            else if (! midi.isEmpty() || ! synth.isSilent())
+                synth.renderNextBlock (buffer, midi, startSample, numSamples);
+        }
+        
+        auto& record = performanceMonitor.getCurrentRecord();
+        record.synthCycles = PerformanceMonitor::getCycles() - startCycles;
+        record.voiceCycles = synth.getVoiceCycles();
+        record.maxVoiceCycles = synth.getMaxVoiceCycles();
+        record.activeVoices = synth.getNumActiveVoices();
+    }
+    
+    void SynthAudioSource::renderOversampled (AudioBuffer<float>& buffer, const MidiBuffer& midi,
+                                              int startSample, int numSamples)
+    {
+        if (midi.isEmpty() && synth.isSilent())
+        {
+            //the voices stopped below their silence level, so whatever the filters still hold is too
+            if (! isDecimatorClear)
+            {
+                decimator.reset();
+                isDecimatorClear = true;
+            }
+            
+            return;
+        }
+        
+        auto numOversampled = numSamples * oversamplingFactor;
+        oversampledBuffer.clear (0, numOversampled);
+        
+        //the same events at the same instants, counted in oversampled samples from the start
+        oversampledMidi.clear();
+        MidiBuffer::Iterator iterator (midi);
+        const uint8* data;
+        int numBytes, samplePosition;
+        
+        while (iterator.getNextEvent (data, numBytes, samplePosition))
+            oversampledMidi.addEvent (data, numBytes, (samplePosition - startSample) * oversamplingFactor);
+        
+        synth.renderNextBlock (oversampledBuffer, oversampledMidi, 0, numOversampled);
+        decimator.process (oversampledBuffer, buffer, startSample, numSamples);
+        isDecimatorClear = false;
+    }
+
+
@@ -0,0 +1,368 @@
+/*
+    File: SynthEngine.h
+    Description: The synthesis engine shared by the GUI application and the headless tools:
+    SynthSound, SynthVoice and SynthAudioSource. Nothing in here depends on the GUI modules.
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AllocationGuard.h"
+#include "Decimator.h"
+#include "NoiseGenerator.h"
+#include "EnvelopeGenerator.h"
+#include "MidiEventQueue.h"
+#include "ModulationMatrix.h"
+#include "ParallelSynthesiser.h"
+#include "SynthParameters.h"
+#include "OutputStage.h"
+#include "PerformanceMonitor.h"
+#include "ResonatorBank.h"
+#include "VelocityCurve.h"
+#include "VoiceFilter.h"
+#include "VoiceFilterBank.h"
+#define CHANNELS 2
+
+//==============================================================================
+struct SynthSound   : public SynthesiserSound
+{
+public:
+    SynthSound();
+    
+    bool appliesToNote    (int) override;
+    bool appliesToChannel (int) override;
+};
+
+//==============================================================================
+//one part of the multi-timbral engine: the patch played by the notes on one MIDI channel. the
+//parameters are set from the message thread; the rest is the audio thread's copy of them, which
+//SynthAudioSource refreshes at the top of every block
+struct SynthPart
+{
+    static constexpr int numParts = ParallelSynthesiser::numMidiChannels;
+    
+    SynthParameters parameters;
+    EnvelopeGenerator::Parameters envelope;
+    VoiceFilter::Topology topology = VoiceFilter::Topology::biquad;
+    NoiseGenerator::Colour noiseColour = NoiseGenerator::Colour::white;
+    float gain = 1.0f;      //the part's volume times its (1 + Q) makeup, for the current block
+};
+
+//==============================================================================
+struct SynthVoice   : public SynthesiserVoice
+{
+public:
+    //how the spread parameter places a note between the channels
+    enum class PanLaw
+    {
+        balanced = 1,       //unity at the centre, the far channel fades out towards the sides
+        constantPower,      //sin/cos, -3 dB at the centre
+        linear              //-6 dB at the centre
+    };
+    
+    SynthVoice();
+    void prepareToPlay( int samplesPerBlockExpected, int numChannels, double sampleRate );
+    
+    //the multiple of the device rate the voice runs at. white noise spreads its power up to
+    //Nyquist, so the excitation is scaled by the factor's square root to keep its density, and
+    //the level in the band, the same as at the device rate
+    void setOversamplingFactor( int factor );
+    void setEnvelopeParameters( const EnvelopeGenerator::Parameters& newParameters );
+    
+    //the voice reads Q from here on the audio thread; set before the voice is first used
+    void setParameters( const SynthParameters& newParameters );
+    
+    //the bank this voice hands its filtering to while the bank is enabled, and the voice's slot
+    //in the pool, which is also its slot in the bank
+    void setFilterBank( VoiceFilterBank* newBank, int voiceIndex );
+    
+    //the resonators this voice feeds while resonator mode is on, routed by the same slot
+    void setResonatorBank( ResonatorBank* newBank );
+    
+    //a voice renders and filters one channel, which the mix pans. stereo noise renders an
+    //independent noise stream per channel instead, for a wide, decorrelated sound at twice the cost
+    void setPanLaw( PanLaw newLaw );
+    void setStereoNoise( bool shouldUseStereoNoise );
+    
+    //switching topology mid-note clears the filter, so it restarts from silence
+    void setFilterTopology( VoiceFilter::Topology newTopology );
+    
+    //restarts the voice's noise on its own streams of seed, one per rendered channel; voices
+    //given different stream numbers never correlate
+    void setNoiseSeed( uint32 seed, int streamNumber );
+    void setNoiseColour( NoiseGenerator::Colour newColour );
+    
+    //with parts set, each new note plays the part for its MIDI channel: its Q, spread, envelope,
+    //topology and noise colour, and its gain in the mix. null plays the one patch set above
+    void setParts( const SynthPart* newParts );
+    
+    //the part the current or last note played, or -1
+    int getPartIndex() const noexcept;
+    
+    //the controllers that move the voice's filter and level, read for the note's channel at the
+    //start of every render; null for none. set before the voice is first used
+    void setModulation( const ModulationMatrix* newModulation );
+    
+    //the tables the patch's velocity curve is looked up in; null takes the velocity as the gain.
+    //set before the voice is first used
+    void setVelocityCurve( const VelocityCurve* newCurve );
+    
+    //while Q glides or the modulation moves, the filter is recomputed every numSamples samples and
+    //its coefficients ramped in between; a new modulated level is ramped to over as many
+    void setControlInterval( int numSamples );
+    
+    //how the voice's buffer is spread over the output; see ParallelSynthesiser::VoiceOutput
+    void getOutput( ParallelSynthesiser::VoiceOutput& output ) const noexcept;
+    bool canPlaySound (SynthesiserSound* sound) override;
+    void startNote (int midiNoteNumber, float velocity,
+                    SynthesiserSound*, int /*currentPitchWheelPosition*/) override;
+    void stopNote (float /*velocity*/, bool allowTailOff) override;
+    void pitchWheelMoved (int) override;
+    void controllerMoved (int, int) override;
+    void renderNextBlock (AudioSampleBuffer& outputBuffer, int startSample, int numSamples) override;
+    
+    //with numSamplesToRamp, the coefficients glide to the new ones over that many samples
+    void updateFilter( int numSamplesToRamp = 0 );
+    float getTargetQ() const;
+    
+    //envelope level times note level, used by the quietest-voice stealing policy
+    float getCurrentLevel() const noexcept;
+    
+    dsp::ProcessSpec spec;
+    
+    //the control interval a voice starts out with, in samples
+    static constexpr int defaultControlInterval = VoiceFilterBank::subBlockSize;
+    
+private:
+    int getNumRenderedChannels() const noexcept;
+    bool isFilteredByMixer() const noexcept;
+    const SynthParameters* getPatchParameters() const noexcept;
+    void updateModulation() noexcept;
+    void applyLevelModulation( float* gains, int numSamples ) noexcept;
+    float getPeakLevel( int numChannels, int numSamples ) const noexcept;
+    float getSilenceThreshold() const noexcept;
+    void endNote();
+    void updatePanGains() noexcept;
+    
+    double level = 0.0;
+    double lastSample[2];
+    bool isOn = false;
+    NoiseGenerator noise, secondNoise;
+    float noiseGain = 1.0f;
+    double frequency;
+    AudioSampleBuffer bufferBuffer; //scratch, sized in prepareToPlay only
+    AudioSampleBuffer envelopeBuffer; //per-sample envelope gains, sized with bufferBuffer
+    EnvelopeGenerator envelope;
+    SmoothedValue<float, ValueSmoothingTypes::Multiplicative> smoothedQ;
+    
+    //one state per rendered channel, sharing the coefficients
+    VoiceFilter filter;
+    int samplesPerBlock = 0;
+    const SynthParameters* parameters = nullptr;
+    const SynthPart* parts = nullptr;
+    const SynthPart* part = nullptr;
+    const ModulationMatrix* modulation = nullptr;
+    const VelocityCurve* velocityCurve = nullptr;
+    float velocityQRatio = 1.0f;
+    int controlInterval = defaultControlInterval;
+    int midiChannel = 0, noteNumber = 0;
+    float cutoffRatio = 1.0f, qRatio = 1.0f;
+    float levelGain = 1.0f, targetLevelGain = 1.0f;
+    bool isModulationMoving = false;
+    VoiceFilterBank* filterBank = nullptr;
+    ResonatorBank* resonatorBank = nullptr;
+    int filterBankIndex = 0;
+    PanLaw panLaw = PanLaw::balanced;
+    bool stereoNoise = false;
+    float pan = 0.0f;
+    float panGains[ParallelSynthesiser::VoiceOutput::maxChannels] = { 1.0f, 1.0f };
+
+};
+
+//==============================================================================
+class SynthAudioSource   : public AudioSource
+{
+public:
+    using StealingPolicy = ParallelSynthesiser::StealingPolicy;
+    using PanLaw = SynthVoice::PanLaw;
+    using FilterTopology = VoiceFilter::Topology;
+    using NoiseColour = NoiseGenerator::Colour;
+    
+    //where the voices' band-pass filters run. both banks only have the biquad, so with any
+    //other topology the voices filter themselves
+    enum class FilterEngine
+    {
+        perVoice = 1,       //each voice runs its own VoiceFilter
+        simdBank,           //a VoiceFilterBank runs them all, several voices per SIMD register
+        resonators          //a ResonatorBank: one always-tuned filter per note, fed by the voices
+    };
+    
+    static constexpr int defaultPolyphony = 8;
+    static constexpr int maxPolyphony = 1024;
+    static constexpr int numParts = SynthPart::numParts;
+    static constexpr int defaultControlInterval = SynthVoice::defaultControlInterval;
+    static constexpr int maxControlInterval = 1024;
+    
+    //the default shortest stretch a block is split into between two MIDI events
+    static constexpr int defaultMinimumSubBlockSize = 16;
+    
+    explicit SynthAudioSource (int numVoices = defaultPolyphony);
+    
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
+    void releaseResources() override;
+    void getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill) override;
+    
+    //live MIDI goes in here, from any thread; getNextAudioBlock plays it one block later at
+    //the sample it arrived at. it can be registered with an AudioDeviceManager as it is
+    MidiEventQueue& getMidiQueue() noexcept { return midiQueue; }
+    
+    //renders a block for an already-timestamped MIDI buffer, replacing the buffer's contents.
+    //used by the offline tools, which have no device clock to time a MidiEventQueue against
+    void renderNextBlock (AudioBuffer<float>& buffer, const MidiBuffer& midi, int startSample, int numSamples);
+    
+    //set values from the message thread; the audio thread picks them up at the next block
+    SynthParameters& getParameters() noexcept { return parameters; }
+    
+    //multi-timbral mode: every MIDI channel plays its own part, with the parameters below in
+    //place of the ones above, all from the one voice pool. only the master volume, the pan law,
+    //stereo noise and the noise seed still apply to every part, and the voices always filter
+    //themselves, since the banks share a single Q. can be changed from any thread; the audio
+    //thread cuts off every sounding note when it switches
+    void setMultitimbral( bool shouldBeMultitimbral ) noexcept  { multitimbral = shouldBeMultitimbral; }
+    bool isMultitimbral() const noexcept                        { return multitimbral; }
+    
+    //partIndex is the MIDI channel minus one
+    SynthParameters& getPartParameters( int partIndex ) noexcept;
+    
+    //the most voices a part may hold at once, from any thread; a part at its limit steals from
+    //its own notes, and 0 silences it. only applies in multi-timbral mode
+    void setPartVoiceLimit( int partIndex, int maxVoices ) noexcept;
+    int getPartVoiceLimit( int partIndex ) const noexcept;
+    
+    //the routes from pitch bend, pressure, aftertouch and CCs to every voice's filter and level.
+    //set them from the message thread; the controllers' state follows the MIDI the synth plays.
+    //the SIMD bank and the resonators keep their filters on the note, so with either of them on
+    //only the level routes apply
+    ModulationMatrix& getModulationMatrix() noexcept { return modulation; }
+    
+    //the custom velocity curve, shared by the master patch and every part; the linear and
+    //exponential ones are fixed. set its points from the message thread
+    VelocityCurve& getVelocityCurve() noexcept { return velocityCurve; }
+    
+    //how often, in device samples, a voice recomputes its filter while Q glides or a modulation
+    //moves, with the coefficients interpolated in between; typically 16 or 32. can be changed
+    //from any thread
+    void setControlInterval( int numSamples ) noexcept  { controlInterval = jlimit (1, maxControlInterval, numSamples); }
+    int getControlInterval() const noexcept             { return controlInterval; }
+    
+    //the gain for the block just rendered at its first and last sample: master volume times
+    //the voices' (1 + Q) makeup gain. advances both smoothers, so call once per block from
+    //the audio thread, after rendering, and hand the result to an OutputStage
+    void advanceOutputGain( int numSamples, float& startGain, float& endGain ) noexcept;
+    
+    //each rendered block fills in the synth and voice timings of the monitor's current record;
+    //whoever owns the device callback adds its own timing and pushes the record
+    PerformanceMonitor& getPerformanceMonitor() noexcept { return performanceMonitor; }
+    
+    //spreads the voices over worker threads; numWorkers = 0 renders serially. the output is
+    //bit-identical either way. call from the message thread while audio is stopped
+    void setRenderOptions( const VoiceRenderScheduler::Options& newOptions );
+    
+    //rebuilds the voice pool with numVoices voices, cutting off any notes that are sounding.
+    //call from the message thread; it can run while audio is playing
+    void setPolyphony( int numVoices );
+    int getPolyphony() const;
+    
+    void setStealingPolicy( StealingPolicy newPolicy );
+    StealingPolicy getStealingPolicy() const;
+    
+    //can be changed from any thread; the audio thread switches at the next block. sounding
+    //notes carry on with their filter state cleared
+    void setFilterEngine( FilterEngine newEngine ) noexcept     { filterEngine = (int) newEngine; }
+    FilterEngine getFilterEngine() const noexcept               { return (FilterEngine) filterEngine.load(); }
+    
+    //the engine the voices end up filtered by: the one set above while the patch's topology is
+    //the biquad and multi-timbral mode is off, per voice otherwise. follows the values as last
+    //set, so the message thread sees its own changes at once
+    FilterEngine getEffectiveFilterEngine() const noexcept;
+    
+    //both can be changed from any thread; the audio thread hands them to the voices at the next
+    //block. the pan law applies to sounding notes too, the spread parameter only to new ones
+    void setPanLaw( PanLaw newLaw ) noexcept                    { panLaw = (int) newLaw; }
+    PanLaw getPanLaw() const noexcept                           { return (PanLaw) panLaw.load(); }
+    void setStereoNoise( bool shouldUseStereoNoise ) noexcept   { stereoNoise = shouldUseStereoNoise; }
+    bool isStereoNoise() const noexcept                         { return stereoNoise; }
+    
+    //the synth splits each block at its MIDI events so every note starts on its own sample,
+    //but never renders a stretch shorter than this between two splits: an event closer than
+    //that to the previous split is played at it, early. can be changed from any thread
+    void setMinimumSubBlockSize( int numSamples ) noexcept      { minimumSubBlockSize = jmax (1, numSamples); }
+    int getMinimumSubBlockSize() const noexcept                 { return minimumSubBlockSize; }
+    
+    //each voice's noise is its own stream of this seed, so the same MIDI always renders the same
+    //samples, whatever the thread count. can be changed from any thread; every stream restarts
+    //from the new seed at the next block, and from the current one at each prepareToPlay
+    void setNoiseSeed( uint32 newSeed ) noexcept                { noiseSeed = newSeed; }
+    uint32 getNoiseSeed() const noexcept                        { return noiseSeed; }
+    
+    //the voices can render at 2x or 4x the device rate, keeping the band-pass true right up to
+    //the top octave, and are brought back down by one shared decimator after the mix. 1, 2 or 4.
+    //re-prepares the voices and cuts off any notes that are sounding; call from the message thread.
+    //the voices' buffers are sized for the highest factor when the device is prepared, and the
+    //new decimator is built before the lock is taken, so the switch never blocks the audio thread
+    //on an allocation
+    void setOversamplingFactor( int newFactor );
+    int getOversamplingFactor() const;
+    
+    //the delay the decimator adds, in device samples; 0 when the voices run at the device rate
+    float getLatencyInSamples() const;
+    
+private:
+    void prepareVoices( int samplesPerBlockExpected, int numChannels );
+    void prepareRenderRate();
+    void ensurePrepared( int numChannels, int numSamples );
+    void updateParameters();
+    void updateParts();
+    void renderSynth( AudioBuffer<float>& buffer, const MidiBuffer& midi, int startSample, int numSamples,
+                      uint64 startCycles );
+    void renderOversampled( AudioBuffer<float>& buffer, const MidiBuffer& midi, int startSample, int numSamples );
+
+    SynthParameters parameters;
+    SynthPart parts[numParts];
+    PerformanceMonitor performanceMonitor;
+    VoiceFilterBank filterBank { maxPolyphony };    //both outlive the synth that mixes through them
+    ResonatorBank resonatorBank { maxPolyphony };
+    ModulationMatrix modulation;                    //watches the synth's MIDI, so outlives it too
+    VelocityCurve velocityCurve;
+    ParallelSynthesiser synth;
+    MidiEventQueue midiQueue;
+    MidiBuffer incomingMidi;
+    double currentSampleRate = 0.0;
+    int preparedBlockSize = 0, preparedChannels = 0;    //at the device rate
+    
+    //the voices' render at the oversampled rate, all guarded by the synth's lock
+    int oversamplingFactor = 1;
+    AudioBuffer<float> oversampledBuffer;
+    MidiBuffer oversampledMidi;
+    Decimator decimator;
+    bool isDecimatorClear = true;
+    EnvelopeGenerator::Parameters voiceEnvelopeParameters;
+    std::atomic<int> filterEngine { (int) FilterEngine::perVoice };
+    std::atomic<int> panLaw { (int) PanLaw::balanced };
+    std::atomic<bool> stereoNoise { false };
+    std::atomic<int> minimumSubBlockSize { defaultMinimumSubBlockSize };
+    std::atomic<uint32> noiseSeed { 0 };
+    std::atomic<bool> multitimbral { false };
+    std::atomic<int> controlInterval { defaultControlInterval };
+    std::atomic<int> partVoiceLimits[numParts];
+    int synthSubBlockSize = 0;
+    int voiceControlInterval = defaultControlInterval;
+    PanLaw voicePanLaw = PanLaw::balanced;
+    FilterTopology voiceTopology = FilterTopology::biquad;
+    NoiseColour voiceNoiseColour = NoiseColour::white;
+    uint32 voiceNoiseSeed = 0;
+    bool voiceStereoNoise = false;
+    bool voiceMultitimbral = false;
+
+};
+
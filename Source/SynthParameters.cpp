@@ -0,0 +1,134 @@
+/*
+    File: SynthParameters.cpp
+    Description: See SynthParameters.h
+*/
+
+#include "SynthParameters.h"
+
+namespace
+{
+    const SynthParameters::Definition definitions[SynthParameters::numParameters] =
+    {
+        //id               name              min      max       default  ramp (s)
+        { "volume",        "Volume",         0.0f,    1.0f,     0.0f,    0.02 },
+        { "q",             "Q",              0.0001f, 1024.0f,  1.0f,    0.05 },
+        { "attack",        "Attack",         0.001f,  5.0f,     0.1f,    0.0  },
+        { "decay",         "Decay",          0.001f,  5.0f,     0.1f,    0.0  },
+        { "sustain",       "Sustain",        0.0f,    1.0f,     1.0f,    0.0  },
+        { "release",       "Release",        0.001f,  5.0f,     0.02f,   0.0  },
+        { "spread",        "Spread",         0.0f,    1.0f,     0.0f,    0.0  },
+        { "filterType",    "Filter type",    1.0f,    5.0f,     1.0f,    0.0  },
+        { "noiseColour",   "Noise colour",   1.0f,    3.0f,     1.0f,    0.0  },
+        { "velocityCurve", "Velocity curve", 1.0f,    3.0f,     1.0f,    0.0  },
+        { "velocityQ",     "Velocity to Q",  -4.0f,   4.0f,     0.0f,    0.0  }
+    };
+}
+
+const SynthParameters::Definition& SynthParameters::getDefinition (int index) noexcept
+{
+    jassert (isPositiveAndBelow (index, (int) numParameters));
+    return definitions[index];
+}
+
+int SynthParameters::getIndexForID (const String& id) noexcept
+{
+    for (int i = 0; i < numParameters; ++i)
+        if (id == definitions[i].id)
+            return i;
+
+    return -1;
+}
+
+SynthParameters::SynthParameters()
+{
+    for (int i = 0; i < numParameters; ++i)
+    {
+        sharedValues[i].value = definitions[i].defaultValue;
+        smoothedValues[i].setCurrentAndTargetValue (definitions[i].defaultValue);
+    }
+}
+
+//==============================================================================
+void SynthParameters::setValue (int index, float newValue) noexcept
+{
+    auto& definition = getDefinition (index);
+    auto& shared = sharedValues[index];
+
+    shared.value = jlimit (definition.minimum, definition.maximum, newValue);
+
+    //already queued means the audio thread hasn't read it yet and will see this value too
+    if (shared.isPending.exchange (true))
+        return;
+
+    int start1, size1, start2, size2;
+    changedFifo.prepareToWrite (1, start1, size1, start2, size2);
+    jassert (size1 + size2 == 1);
+
+    //still never lost: the flag stays set and the next pull picks up every parameter
+    if (size1 + size2 == 0)
+    {
+        needsFullPull = true;
+        return;
+    }
+
+    changedIndices[size1 > 0 ? start1 : start2] = index;
+    changedFifo.finishedWrite (size1 + size2);
+}
+
+float SynthParameters::getValue (int index) const noexcept
+{
+    return sharedValues[index].value.load();
+}
+
+//==============================================================================
+void SynthParameters::prepare (double sampleRate) noexcept
+{
+    //anything set before playback starts is applied immediately rather than glided to
+    pullChanges();
+
+    for (int i = 0; i < numParameters; ++i)
+        smoothedValues[i].reset (sampleRate, definitions[i].rampSeconds);
+}
+
+bool SynthParameters::pullChanges() noexcept
+{
+    auto isFullPull = needsFullPull.exchange (false);
+    auto numChanged = changedFifo.getNumReady();
+
+    if (numChanged == 0 && ! isFullPull)
+        return false;
+
+    int start1, size1, start2, size2;
+    changedFifo.prepareToRead (numChanged, start1, size1, start2, size2);
+
+    auto pull = [this] (int index)
+    {
+        auto& shared = sharedValues[index];
+
+        //cleared before reading, so a value written in between is queued again rather than lost
+        shared.isPending = false;
+        auto newValue = shared.value.load();
+
+        if (definitions[index].rampSeconds > 0.0)
+            smoothedValues[index].setTargetValue (newValue);
+        else
+            smoothedValues[index].setCurrentAndTargetValue (newValue);
+    };
+
+    if (isFullPull)
+    {
+        for (int i = 0; i < numParameters; ++i)
+            pull (i);
+    }
+    else
+    {
+        for (int i = 0; i < size1; ++i)
+            pull (changedIndices[start1 + i]);
+
+        for (int i = 0; i < size2; ++i)
+            pull (changedIndices[start2 + i]);
+    }
+
+    changedFifo.finishedRead (size1 + size2);
+    return true;
+}
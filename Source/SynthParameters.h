@@ -0,0 +1,98 @@
+/*
+    File: SynthParameters.h
+    Description: The synth's parameter tree, in the spirit of AudioProcessorValueTreeState: one
+    table of IDs, ranges, defaults and smoothing times for every user-facing parameter.
+
+    Values are set on the message thread (the single producer) and delivered to the audio thread
+    (the single consumer) through a lock-free FIFO of changed indices. The shared values are padded
+    so that no cache line holds two of them, and the audio thread only reads one after it was told
+    it changed, so in the steady state the two threads touch no common memory at all.
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class SynthParameters
+{
+public:
+    enum Index
+    {
+        volume,
+        q,
+        attack,
+        decay,
+        sustain,
+        release,
+        spread,
+        filterType,     //a VoiceFilter::Topology, stored as its ID
+        noiseColour,    //a NoiseGenerator::Colour, stored as its ID
+        velocityCurve,  //a VelocityCurve::Shape, stored as its ID
+        velocityQ,      //octaves of Q added at full velocity; negative opens the band up
+        numParameters
+    };
+
+    struct Definition
+    {
+        const char* id;
+        const char* name;
+        float minimum, maximum, defaultValue;
+        double rampSeconds;     //0 for parameters that are only read at note boundaries
+    };
+
+    static const Definition& getDefinition (int index) noexcept;
+
+    //-1 if there's no parameter with that ID
+    static int getIndexForID (const String& id) noexcept;
+
+    SynthParameters();
+
+    //==============================================================================
+    //message thread. the value is clamped to the parameter's range
+    void setValue (int index, float newValue) noexcept;
+    float getValue (int index) const noexcept;
+
+    //==============================================================================
+    //audio thread, before playback. applies any pending changes and resets every smoother to
+    //its target with the new sample rate
+    void prepare (double sampleRate) noexcept;
+
+    //picks up whatever the message thread changed since the last call and retargets the
+    //smoothers; returns true if anything changed. call once at the top of each block
+    bool pullChanges() noexcept;
+
+    //the latest value, with no smoothing applied
+    float getTargetValue (int index) const noexcept     { return smoothedValues[index].getTargetValue(); }
+
+    //for parameters smoothed centrally, e.g. the master volume
+    SmoothedValue<float>& getSmoothedValue (int index) noexcept     { return smoothedValues[index]; }
+
+private:
+    //padded by a whole line rather than aligned to one: new ignores alignment beyond 16 bytes
+    //before C++17, and the padding keeps two values off the same line wherever the tree lands
+    static constexpr int cacheLineSize = 64;
+
+    struct SharedValue
+    {
+        std::atomic<float> value { 0.0f };
+        std::atomic<bool> isPending { false };
+        char padding[cacheLineSize];
+    };
+
+    SharedValue sharedValues[numParameters];
+
+    //an index is queued at most once while it's pending and once more while pullChanges() is
+    //reading it, so two slots per parameter can never fill up
+    static constexpr int fifoSize = 2 * numParameters + 1;
+
+    AbstractFifo changedFifo { fifoSize };
+    int changedIndices[fifoSize];
+
+    //set if a change ever found the FIFO full anyway; the audio thread then rereads everything
+    std::atomic<bool> needsFullPull { false };
+
+    SmoothedValue<float> smoothedValues[numParameters];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SynthParameters)
+};
@@ -0,0 +1,116 @@
+/*
+    File: VelocityCurve.cpp
+    Description: See VelocityCurve.h
+*/
+
+#include "VelocityCurve.h"
+
+VelocityCurve::VelocityCurve()
+{
+    auto* linear = tables[(int) Shape::linear - 1];
+    auto* exponential = tables[(int) Shape::exponential - 1];
+
+    //velocity 0 is a note-off, but is silent in every curve anyway
+    for (int velocity = 0; velocity < tableSize; ++velocity)
+    {
+        auto proportion = (float) velocity / (float) (tableSize - 1);
+
+        linear[velocity] = proportion;
+        exponential[velocity] = velocity > 0 ? Decibels::decibelsToGain (exponentialRangeDecibels * (proportion - 1.0f))
+                                             : 0.0f;
+    }
+
+    //the custom curve is linear until one is set
+    std::copy (linear, linear + tableSize, tables[(int) Shape::custom - 1]);
+}
+
+VelocityCurve::~VelocityCurve() {}
+
+void VelocityCurve::setCustomPoints (const Array<CurvePoint>& points)
+{
+    jassert (! points.isEmpty());
+
+    float table[tableSize];
+
+    for (int velocity = 0; velocity < tableSize; ++velocity)
+    {
+        auto x = (float) velocity;
+        auto next = 0;
+
+        while (next < points.size() && points.getReference (next).velocity < x)
+            ++next;
+
+        float gain;
+
+        if (points.isEmpty())
+            gain = x / (float) (tableSize - 1);
+        else if (next == 0)
+            gain = points.getFirst().gain;
+        else if (next == points.size())
+            gain = points.getLast().gain;
+        else
+        {
+            auto& from = points.getReference (next - 1);
+            auto& to = points.getReference (next);
+            gain = from.gain + (to.gain - from.gain) * (x - from.velocity) / jmax (1.0e-6f, to.velocity - from.velocity);
+        }
+
+        table[velocity] = jlimit (0.0f, 1.0f, gain);
+    }
+
+    const SpinLock::ScopedLockType sl (pendingLock);
+
+    std::copy (table, table + tableSize, pendingCustom);
+    isCustomPending = true;
+}
+
+bool VelocityCurve::parsePoints (const String& text, Array<CurvePoint>& points)
+{
+    Array<CurvePoint> parsed;
+
+    for (auto& token : StringArray::fromTokens (text, ",", {}))
+    {
+        auto velocity = token.upToFirstOccurrenceOf (":", false, false).trim();
+        auto gain = token.fromFirstOccurrenceOf (":", false, false).trim();
+
+        if (! token.containsChar (':') || velocity.isEmpty() || gain.isEmpty()
+             || ! velocity.containsOnly ("0123456789.") || ! gain.containsOnly ("0123456789."))
+            return false;
+
+        CurvePoint point { velocity.getFloatValue(), gain.getFloatValue() };
+
+        if (point.velocity > (float) (tableSize - 1) || (! parsed.isEmpty() && point.velocity <= parsed.getLast().velocity))
+            return false;
+
+        parsed.add (point);
+    }
+
+    if (parsed.isEmpty())
+        return false;
+
+    points = parsed;
+    return true;
+}
+
+String VelocityCurve::getShapeName (Shape shape)
+{
+    switch (shape)
+    {
+        case Shape::linear:         return "linear";
+        case Shape::exponential:    return "exponential";
+        case Shape::custom:         return "custom";
+        default:                    return {};
+    }
+}
+
+void VelocityCurve::pullChanges() noexcept
+{
+    const GenericScopedTryLock<SpinLock> sl (pendingLock);
+
+    //the message thread is halfway through a new curve; it will still be pending next block
+    if (! sl.isLocked() || ! isCustomPending)
+        return;
+
+    std::copy (pendingCustom, pendingCustom + tableSize, tables[(int) Shape::custom - 1]);
+    isCustomPending = false;
+}
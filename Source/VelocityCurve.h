@@ -0,0 +1,73 @@
+/*
+    File: VelocityCurve.h
+    Description: Turns a note-on velocity into the note's level. Every curve is a 128-entry table,
+    one gain per MIDI velocity, built before playback, so starting a note costs a single lookup
+    and nothing about velocity reaches the per-sample loop.
+
+    The linear and exponential curves are fixed. The custom one is drawn as straight lines
+    through a list of points; it is built on the message thread and handed to the audio thread
+    behind a spin lock that the audio thread only ever tries, so it never waits.
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class VelocityCurve
+{
+public:
+    enum class Shape
+    {
+        linear = 1,         //gain proportional to velocity
+        exponential,        //even steps in decibels, over exponentialRangeDecibels
+        custom              //straight lines through the points set with setCustomPoints
+    };
+
+    //one point the custom curve passes through
+    struct CurvePoint
+    {
+        float velocity;     //0 to 127
+        float gain;         //0 to 1
+    };
+
+    static constexpr int tableSize = 128;
+    static constexpr float exponentialRangeDecibels = 40.0f;
+
+    VelocityCurve();
+    ~VelocityCurve();
+
+    //==============================================================================
+    //message thread. the points are in rising order of velocity; the curve is flat before the
+    //first and after the last. the audio thread picks it up at its next pullChanges()
+    void setCustomPoints (const Array<CurvePoint>& points);
+
+    //parses "<velocity>:<gain>,..." e.g. "0:0,64:0.2,127:1"
+    static bool parsePoints (const String& text, Array<CurvePoint>& points);
+
+    static String getShapeName (Shape shape);
+
+    //==============================================================================
+    //audio thread, once at the top of each block
+    void pullChanges() noexcept;
+
+    //the gain for a velocity from 0 to 1, as Synthesiser hands it to a voice
+    float getGain (Shape shape, float velocity) const noexcept
+    {
+        auto table = jlimit ((int) Shape::linear, (int) Shape::custom, (int) shape) - 1;
+        return tables[table][jlimit (0, tableSize - 1, roundToInt (velocity * (tableSize - 1)))];
+    }
+
+private:
+    static constexpr int numShapes = 3;
+
+    //read by the voices on the audio thread
+    float tables[numShapes][tableSize];
+
+    //written by the message thread
+    SpinLock pendingLock;
+    float pendingCustom[tableSize];
+    bool isCustomPending = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VelocityCurve)
+};
@@ -0,0 +1,307 @@
+/*
+    File: VoiceFilter.cpp
+    Description: See VoiceFilter.h
+*/
+
+#include "VoiceFilter.h"
+#include "BandPassCoefficientCache.h"
+
+namespace
+{
+    //each kernel filters a block with its state held in locals, and only writes the state back
+    //(snapped to zero, as dsp::IIR::Filter does) at the end. a ramping kernel also adds the
+    //increments to its coefficients after every sample; the steady one compiles without them
+
+    //b0, b1, b2, a1, a2 shared by numStages identical sections; z1 and z2 per section.
+    //one section is the same arithmetic in the same order as dsp::IIR::Filter
+    template <int numStages>
+    struct BiquadCascade
+    {
+        template <bool isRamping>
+        static void process (const float* c, const float* dc, float* z, float* samples, int numSamples) noexcept
+        {
+            auto b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+            float z1[numStages], z2[numStages];
+
+            for (int stage = 0; stage < numStages; ++stage)
+            {
+                z1[stage] = z[2 * stage];
+                z2[stage] = z[2 * stage + 1];
+            }
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto x = samples[i];
+
+                for (int stage = 0; stage < numStages; ++stage)
+                {
+                    auto y = (b0 * x) + z1[stage];
+                    z1[stage] = (b1 * x) - (y * a1) + z2[stage];
+                    z2[stage] = (b2 * x) - (y * a2);
+                    x = y;
+                }
+
+                samples[i] = x;
+
+                if (isRamping)
+                {
+                    b0 += dc[0]; b1 += dc[1]; b2 += dc[2]; a1 += dc[3]; a2 += dc[4];
+                }
+            }
+
+            for (int stage = 0; stage < numStages; ++stage)
+            {
+                JUCE_SNAP_TO_ZERO (z1[stage]);
+                JUCE_SNAP_TO_ZERO (z2[stage]);
+                z[2 * stage] = z1[stage];
+                z[2 * stage + 1] = z2[stage];
+            }
+        }
+    };
+
+    //Andrew Simper's trapezoidal SVF: a1, a2, a3 and the damping k; the two integrator states.
+    //the band output is scaled by k for a peak gain of 1
+    struct StateVariable
+    {
+        template <bool isRamping>
+        static void process (const float* c, const float* dc, float* z, float* samples, int numSamples) noexcept
+        {
+            auto a1 = c[0], a2 = c[1], a3 = c[2], k = c[3];
+            auto ic1 = z[0], ic2 = z[1];
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto v3 = samples[i] - ic2;
+                auto v1 = a1 * ic1 + a2 * v3;
+                auto v2 = ic2 + a2 * ic1 + a3 * v3;
+                ic1 = 2.0f * v1 - ic1;
+                ic2 = 2.0f * v2 - ic2;
+                samples[i] = k * v1;
+
+                if (isRamping)
+                {
+                    a1 += dc[0]; a2 += dc[1]; a3 += dc[2]; k += dc[3];
+                }
+            }
+
+            JUCE_SNAP_TO_ZERO (ic1);
+            JUCE_SNAP_TO_ZERO (ic2);
+            z[0] = ic1;
+            z[1] = ic2;
+        }
+    };
+
+    //four trapezoidal one-poles, each with gain G = g / (1 + g), in a loop with feedback k. the
+    //loop is solved for each sample rather than delayed by one, so the resonance tracks the
+    //cutoff exactly. tapping y2 - 2 y3 + y4 gives two high-pass and two low-pass poles, whose
+    //gain at the cutoff is 1 / (4 - k); the output gain undoes it
+    struct Ladder
+    {
+        template <bool isRamping>
+        static void process (const float* c, const float* dc, float* z, float* samples, int numSamples) noexcept
+        {
+            auto g = c[0], oneMinusG = c[1], k = c[2], feedbackScale = c[3], gain = c[4];
+            auto s1 = z[0], s2 = z[1], s3 = z[2], s4 = z[3];
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                //what the last stage would output for no input, from the stages' states
+                auto zeroInputOutput = oneMinusG * (((s1 * g + s2) * g + s3) * g + s4);
+                auto u = (samples[i] - k * zeroInputOutput) * feedbackScale;
+
+                auto v1 = (u - s1) * g;     auto y1 = v1 + s1;     s1 = y1 + v1;
+                auto v2 = (y1 - s2) * g;    auto y2 = v2 + s2;     s2 = y2 + v2;
+                auto v3 = (y2 - s3) * g;    auto y3 = v3 + s3;     s3 = y3 + v3;
+                auto v4 = (y3 - s4) * g;    auto y4 = v4 + s4;     s4 = y4 + v4;
+
+                samples[i] = gain * (y2 - 2.0f * y3 + y4);
+
+                if (isRamping)
+                {
+                    g += dc[0]; oneMinusG += dc[1]; k += dc[2]; feedbackScale += dc[3]; gain += dc[4];
+                }
+            }
+
+            JUCE_SNAP_TO_ZERO (s1);
+            JUCE_SNAP_TO_ZERO (s2);
+            JUCE_SNAP_TO_ZERO (s3);
+            JUCE_SNAP_TO_ZERO (s4);
+            z[0] = s1;
+            z[1] = s2;
+            z[2] = s3;
+            z[3] = s4;
+        }
+    };
+
+    //the Q each of n identical band-pass sections needs for the cascade to keep the -3 dB
+    //bandwidth of a single section at q: near the centre each section's power response is
+    //1 / (1 + x^2) with x proportional to Q, so (1 + x^2)^n = 2 at x^2 = 2^(1/n) - 1
+    double getSectionQ (double q, int numStages) noexcept
+    {
+        return q * std::sqrt (std::pow (2.0, 1.0 / numStages) - 1.0);
+    }
+
+    //the prewarped integrator gain, with the cutoff kept clear of Nyquist
+    double getIntegratorGain (double frequency, double sampleRate) noexcept
+    {
+        return std::tan (MathConstants<double>::pi * jmin (frequency, 0.49 * sampleRate) / sampleRate);
+    }
+}
+
+//==============================================================================
+VoiceFilter::VoiceFilter() {}
+
+void VoiceFilter::setTopology (Topology newTopology) noexcept
+{
+    if (newTopology == topology)
+        return;
+
+    topology = newTopology;
+    coefficientsValid = false;
+    rampLength = 0;
+    reset();
+}
+
+String VoiceFilter::getTopologyName (Topology topology)
+{
+    switch (topology)
+    {
+        case Topology::biquad:          return "biquad";
+        case Topology::stateVariable:   return "svf";
+        case Topology::biquad4:         return "biquad4";
+        case Topology::biquad8:         return "biquad8";
+        case Topology::ladder:          return "ladder";
+        default:                        return {};
+    }
+}
+
+void VoiceFilter::prepare (double newSampleRate) noexcept
+{
+    sampleRate = newSampleRate;
+    coefficientsValid = false;
+    rampLength = 0;
+    reset();
+}
+
+void VoiceFilter::reset() noexcept
+{
+    for (int channel = 0; channel < maxChannels; ++channel)
+        reset (channel);
+}
+
+void VoiceFilter::reset (int channel) noexcept
+{
+    std::fill (states[channel], states[channel] + maxStates, 0.0f);
+}
+
+bool VoiceFilter::update (double frequency, double q) noexcept
+{
+    rampLength = 0;
+
+    //modulation can push the centre up past Nyquist
+    frequency = jmin (frequency, 0.49 * sampleRate);
+
+    if (coefficientsValid && frequency == lastFrequency && q == lastQ)
+        return false;
+
+    coefficientsValid = true;
+    lastFrequency = frequency;
+    lastQ = q;
+
+    switch (topology)
+    {
+        case Topology::stateVariable:
+        {
+            auto g = getIntegratorGain (frequency, sampleRate);
+            auto k = 1.0 / q;
+            auto a1 = 1.0 / (1.0 + g * (g + k));
+
+            coefficients[0] = (float) a1;
+            coefficients[1] = (float) (g * a1);
+            coefficients[2] = (float) (g * g * a1);
+            coefficients[3] = (float) k;
+            break;
+        }
+
+        case Topology::ladder:
+        {
+            //Q = 0.5 is the ladder without feedback; higher Qs approach self-oscillation at k = 4
+            auto g = getIntegratorGain (frequency, sampleRate);
+            auto stageGain = g / (1.0 + g);
+            auto k = jmax (0.0, 4.0 - 2.0 / q);
+
+            coefficients[0] = (float) stageGain;
+            coefficients[1] = (float) (1.0 - stageGain);
+            coefficients[2] = (float) k;
+            coefficients[3] = (float) (1.0 / (1.0 + k * std::pow (stageGain, 4.0)));
+            coefficients[4] = (float) (4.0 - k);
+            break;
+        }
+
+        case Topology::biquad4:
+            BandPassCoefficientCache::calculate (sampleRate, frequency, getSectionQ (q, 2), coefficients);
+            break;
+
+        case Topology::biquad8:
+            BandPassCoefficientCache::calculate (sampleRate, frequency, getSectionQ (q, 4), coefficients);
+            break;
+
+        case Topology::biquad:
+        default:
+            BandPassCoefficientCache::calculate (sampleRate, frequency, q, coefficients);
+            break;
+    }
+
+    return true;
+}
+
+bool VoiceFilter::updateRamped (double frequency, double q, int numSamples) noexcept
+{
+    //a filter with nothing to ramp from jumps straight to the new coefficients
+    if (! coefficientsValid || numSamples <= 0)
+        return update (frequency, q);
+
+    float previous[maxCoefficients];
+    std::copy (coefficients, coefficients + maxCoefficients, previous);
+
+    if (! update (frequency, q))
+        return false;
+
+    for (int i = 0; i < maxCoefficients; ++i)
+    {
+        rampStart[i] = previous[i];
+        increments[i] = (coefficients[i] - previous[i]) / (float) numSamples;
+    }
+
+    rampLength = numSamples;
+    return true;
+}
+
+void VoiceFilter::process (int channel, float* samples, int numSamples) noexcept
+{
+    jassert (isPositiveAndBelow (channel, maxChannels));
+
+    if (rampLength > 0)
+    {
+        jassert (numSamples <= rampLength);
+        processWith<true> (rampStart, states[channel], samples, numSamples);
+    }
+    else
+    {
+        processWith<false> (coefficients, states[channel], samples, numSamples);
+    }
+}
+
+template <bool isRamping>
+void VoiceFilter::processWith (const float* c, float* state, float* samples, int numSamples) const noexcept
+{
+    switch (topology)
+    {
+        case Topology::stateVariable:   StateVariable::process<isRamping> (c, increments, state, samples, numSamples); break;
+        case Topology::biquad4:         BiquadCascade<2>::process<isRamping> (c, increments, state, samples, numSamples); break;
+        case Topology::biquad8:         BiquadCascade<4>::process<isRamping> (c, increments, state, samples, numSamples); break;
+        case Topology::ladder:          Ladder::process<isRamping> (c, increments, state, samples, numSamples); break;
+        case Topology::biquad:
+        default:                        BiquadCascade<1>::process<isRamping> (c, increments, state, samples, numSamples); break;
+    }
+}
@@ -0,0 +1,76 @@
+/*
+    File: VoiceFilter.h
+    Description: A voice's band-pass filter, in one of several topologies chosen by the patch's
+    filter type. Every topology is tuned so that its peak gain is 1 at the note's frequency and
+    Q sets its width, so switching changes the character and the skirts but not the level.
+
+    The coefficients are shared by the voice's channels; each channel has its own state. The
+    topology is picked once per process call and every one has its own inner loop, specialised
+    at compile time, so there is no dispatch per sample.
+
+    While the frequency or Q move, the coefficients can be ramped linearly from one update to
+    the next instead of jumping, so they only need recomputing every few samples.
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class VoiceFilter
+{
+public:
+    enum class Topology
+    {
+        biquad = 1,         //the RBJ band-pass, transposed direct form II
+        stateVariable,      //a TPT state-variable filter; stays well behaved while Q moves
+        biquad4,            //two biquads in series, 4th order, the same -3 dB bandwidth
+        biquad8,            //four biquads in series, 8th order, the same -3 dB bandwidth
+        ladder              //a zero-delay-feedback 4-pole ladder, tapped for a band-pass
+    };
+
+    static constexpr int maxChannels = 2;
+
+    VoiceFilter();
+
+    //changing the topology clears every channel's state
+    void setTopology (Topology newTopology) noexcept;
+    Topology getTopology() const noexcept                   { return topology; }
+
+    static String getTopologyName (Topology topology);
+
+    void prepare (double sampleRate) noexcept;
+    void reset() noexcept;
+    void reset (int channel) noexcept;
+
+    //recomputes the coefficients if the frequency or Q differ from the previous call, or the
+    //sample rate or topology changed since; returns true when they were recomputed
+    bool update (double frequency, double q) noexcept;
+
+    //the same, but until the next update, process glides each channel from the old coefficients
+    //to the new ones over numSamples samples; filter no more than that per channel in between
+    bool updateRamped (double frequency, double q, int numSamples) noexcept;
+
+    //filters one channel in place, with the coefficients of the last update
+    void process (int channel, float* samples, int numSamples) noexcept;
+
+    //the most coefficients and state variables any topology uses
+    static constexpr int maxCoefficients = 5;
+    static constexpr int maxStates = 8;
+
+private:
+    template <bool isRamping>
+    void processWith (const float* c, float* state, float* samples, int numSamples) const noexcept;
+
+    Topology topology = Topology::biquad;
+    double sampleRate = 44100.0;
+    double lastFrequency = 0.0, lastQ = 0.0;
+    bool coefficientsValid = false;
+
+    float coefficients[maxCoefficients] = {};
+    float rampStart[maxCoefficients] = {}, increments[maxCoefficients] = {};
+    int rampLength = 0;
+    float states[maxChannels][maxStates] = {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VoiceFilter)
+};
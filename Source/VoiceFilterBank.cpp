@@ -0,0 +1,367 @@
+/*
+    File: VoiceFilterBank.cpp
+    Description: See VoiceFilterBank.h. The biquad kernel is written once against a tiny set of
+    vector operations and instantiated for 1, 2 or 4 vectors per group; the vectors of a group are
+    independent, so their feedback chains overlap in the pipeline.
+*/
+
+#include "VoiceFilterBank.h"
+
+#if JUCE_INTEL
+ #include <emmintrin.h>
+ #define BANK_USE_SSE2 1
+#elif JUCE_ARM && (defined (__ARM_NEON__) || defined (__ARM_NEON))
+ #include <arm_neon.h>
+ #define BANK_USE_NEON 1
+#endif
+
+namespace
+{
+   #if BANK_USE_SSE2
+    struct VectorOps
+    {
+        using Vector = __m128;
+        static constexpr int width = 4;
+
+        static Vector load (const float* src) noexcept                  { return _mm_loadu_ps (src); }
+        static void store (float* dest, Vector v) noexcept              { _mm_storeu_ps (dest, v); }
+        static Vector add (Vector a, Vector b) noexcept                 { return _mm_add_ps (a, b); }
+        static Vector sub (Vector a, Vector b) noexcept                 { return _mm_sub_ps (a, b); }
+        static Vector mul (Vector a, Vector b) noexcept                 { return _mm_mul_ps (a, b); }
+
+        static float sum (Vector v) noexcept
+        {
+            v = _mm_add_ps (v, _mm_movehl_ps (v, v));
+            v = _mm_add_ss (v, _mm_shuffle_ps (v, v, _MM_SHUFFLE (1, 1, 1, 1)));
+            return _mm_cvtss_f32 (v);
+        }
+    };
+   #elif BANK_USE_NEON
+    struct VectorOps
+    {
+        using Vector = float32x4_t;
+        static constexpr int width = 4;
+
+        static Vector load (const float* src) noexcept                  { return vld1q_f32 (src); }
+        static void store (float* dest, Vector v) noexcept              { vst1q_f32 (dest, v); }
+        static Vector add (Vector a, Vector b) noexcept                 { return vaddq_f32 (a, b); }
+        static Vector sub (Vector a, Vector b) noexcept                 { return vsubq_f32 (a, b); }
+        static Vector mul (Vector a, Vector b) noexcept                 { return vmulq_f32 (a, b); }
+
+        static float sum (Vector v) noexcept
+        {
+            auto pair = vadd_f32 (vget_low_f32 (v), vget_high_f32 (v));
+            return vget_lane_f32 (vpadd_f32 (pair, pair), 0);
+        }
+    };
+   #else
+    struct VectorOps
+    {
+        struct Vector { float lanes[4]; };
+        static constexpr int width = 4;
+
+        static Vector load (const float* src) noexcept                  { return { { src[0], src[1], src[2], src[3] } }; }
+        static void store (float* dest, Vector v) noexcept              { for (int i = 0; i < width; ++i) dest[i] = v.lanes[i]; }
+        static Vector add (Vector a, Vector b) noexcept                 { for (int i = 0; i < width; ++i) a.lanes[i] += b.lanes[i]; return a; }
+        static Vector sub (Vector a, Vector b) noexcept                 { for (int i = 0; i < width; ++i) a.lanes[i] -= b.lanes[i]; return a; }
+        static Vector mul (Vector a, Vector b) noexcept                 { for (int i = 0; i < width; ++i) a.lanes[i] *= b.lanes[i]; return a; }
+        static float sum (Vector v) noexcept                            { return (v.lanes[0] + v.lanes[2]) + (v.lanes[1] + v.lanes[3]); }
+    };
+   #endif
+
+    //==============================================================================
+    //the transposed direct form II of dsp::IIR::Filter, with the same operation order, run on
+    //numVectors * width voice channels at once. frames holds one lane-interleaved frame per
+    //sample; every lane's output, weighted by its gains, is added to the two mixes
+    template <typename Ops, int numVectors>
+    void processBiquads (VoiceFilterBank::GroupPlanes& planes, const float* frames,
+                         float* mix0, float* mix1, int numSamples) noexcept
+    {
+        constexpr int numLanes = numVectors * Ops::width;
+        typename Ops::Vector b0[numVectors], b1[numVectors], b2[numVectors],
+                             a1[numVectors], a2[numVectors], z1[numVectors], z2[numVectors],
+                             gain0[numVectors], gain1[numVectors];
+
+        for (int v = 0; v < numVectors; ++v)
+        {
+            auto offset = v * Ops::width;
+            b0[v] = Ops::load (planes[VoiceFilterBank::b0] + offset);
+            b1[v] = Ops::load (planes[VoiceFilterBank::b1] + offset);
+            b2[v] = Ops::load (planes[VoiceFilterBank::b2] + offset);
+            a1[v] = Ops::load (planes[VoiceFilterBank::a1] + offset);
+            a2[v] = Ops::load (planes[VoiceFilterBank::a2] + offset);
+            z1[v] = Ops::load (planes[VoiceFilterBank::z1] + offset);
+            z2[v] = Ops::load (planes[VoiceFilterBank::z2] + offset);
+            gain0[v] = Ops::load (planes[VoiceFilterBank::gain0] + offset);
+            gain1[v] = Ops::load (planes[VoiceFilterBank::gain1] + offset);
+        }
+
+        for (int i = 0; i < numSamples; ++i, frames += numLanes)
+        {
+            typename Ops::Vector output[numVectors];
+
+            for (int v = 0; v < numVectors; ++v)
+            {
+                auto input = Ops::load (frames + v * Ops::width);
+                output[v] = Ops::add (Ops::mul (input, b0[v]), z1[v]);
+                z1[v] = Ops::add (Ops::sub (Ops::mul (input, b1[v]), Ops::mul (output[v], a1[v])), z2[v]);
+                z2[v] = Ops::sub (Ops::mul (input, b2[v]), Ops::mul (output[v], a2[v]));
+            }
+
+            auto sum0 = Ops::mul (output[0], gain0[0]);
+            auto sum1 = Ops::mul (output[0], gain1[0]);
+
+            for (int v = 1; v < numVectors; ++v)
+            {
+                sum0 = Ops::add (sum0, Ops::mul (output[v], gain0[v]));
+                sum1 = Ops::add (sum1, Ops::mul (output[v], gain1[v]));
+            }
+
+            mix0[i] += Ops::sum (sum0);
+            mix1[i] += Ops::sum (sum1);
+        }
+
+        for (int v = 0; v < numVectors; ++v)
+        {
+            Ops::store (planes[VoiceFilterBank::z1] + v * Ops::width, z1[v]);
+            Ops::store (planes[VoiceFilterBank::z2] + v * Ops::width, z2[v]);
+        }
+    }
+
+    void processBiquads (int numLanes, VoiceFilterBank::GroupPlanes& planes, const float* frames,
+                         float* mix0, float* mix1, int numSamples) noexcept
+    {
+        switch (numLanes / VectorOps::width)
+        {
+            case 4:  processBiquads<VectorOps, 4> (planes, frames, mix0, mix1, numSamples); break;
+            case 2:  processBiquads<VectorOps, 2> (planes, frames, mix0, mix1, numSamples); break;
+            case 1:
+            default: processBiquads<VectorOps, 1> (planes, frames, mix0, mix1, numSamples); break;
+        }
+    }
+
+    static_assert (VoiceFilterBank::maxLanes == 4 * VectorOps::width, "the groups are 1, 2 or 4 vectors wide");
+}
+
+//==============================================================================
+VoiceFilterBank::VoiceFilterBank (int numVoiceSlots)
+    : capacity (jmax (1, numVoiceSlots)),
+      coefficients ((size_t) (5 * capacity), true),
+      states ((size_t) (2 * capacity * maxChannels), true),
+      frequencies ((size_t) capacity, true),
+      coefficientCaches (new BandPassCoefficientCache[(size_t) capacity]),
+      lanes ((size_t) (capacity * maxChannels))
+{
+    zerostruct (groupPlanes);
+}
+
+VoiceFilterBank::~VoiceFilterBank() {}
+
+void VoiceFilterBank::prepare (double newSampleRate, int maximumBlockSize)
+{
+    sampleRate = newSampleRate;
+    preparedBlockSize = maximumBlockSize;
+
+    if (maximumBlockSize > allocatedBlockSize)
+    {
+        allocatedBlockSize = maximumBlockSize;
+        frames.allocate ((size_t) (maximumBlockSize * maxLanes), true);
+
+        for (auto& mix : mixes)
+            mix.allocate ((size_t) maximumBlockSize, true);
+
+        auto maxChunks = maximumBlockSize / subBlockSize + 1;
+        chunkQ.allocate ((size_t) maxChunks, true);
+        chunkLength.allocate ((size_t) maxChunks, true);
+    }
+
+    for (int i = 0; i < capacity; ++i)
+        coefficientCaches[i].invalidate();
+
+    smoothedQ.reset (sampleRate, SynthParameters::getDefinition (SynthParameters::q).rampSeconds);
+    smoothedQ.setCurrentAndTargetValue (getTargetQ());
+}
+
+float VoiceFilterBank::getTargetQ() const noexcept
+{
+    jassert (parameters != nullptr);
+
+    return parameters != nullptr ? parameters->getTargetValue (SynthParameters::q)
+                                 : SynthParameters::getDefinition (SynthParameters::q).defaultValue;
+}
+
+void VoiceFilterBank::setEnabled (bool shouldBeEnabled) noexcept
+{
+    if (shouldBeEnabled && ! enabled)
+    {
+        //the voices' own filters have been running meanwhile; starting from silence can't click
+        FloatVectorOperations::clear (states, 2 * capacity * maxChannels);
+        smoothedQ.setCurrentAndTargetValue (getTargetQ());
+    }
+
+    enabled = shouldBeEnabled;
+}
+
+void VoiceFilterBank::startVoice (int voiceIndex, double frequency) noexcept
+{
+    jassert (isPositiveAndBelow (voiceIndex, capacity));
+
+    if (! isPositiveAndBelow (voiceIndex, capacity))
+        return;
+
+    frequencies[voiceIndex] = frequency;
+
+    for (int plane = 0; plane < 2; ++plane)
+        for (int channel = 0; channel < maxChannels; ++channel)
+            states[(plane * capacity + voiceIndex) * maxChannels + channel] = 0.0f;
+}
+
+float VoiceFilterBank::getStateLevel (int voiceIndex) const noexcept
+{
+    jassert (isPositiveAndBelow (voiceIndex, capacity));
+
+    float level = 0.0f;
+
+    for (int plane = 0; plane < 2; ++plane)
+        for (int channel = 0; channel < maxChannels; ++channel)
+            level = jmax (level, std::abs (states[(plane * capacity + voiceIndex) * maxChannels + channel]));
+
+    return level;
+}
+
+//==============================================================================
+void VoiceFilterBank::mixVoices (AudioBuffer<float>& output, int startSample, int numSamples,
+                                 const OwnedArray<AudioBuffer<float>>& voiceBuffers,
+                                 const ParallelSynthesiser::VoiceOutput* voiceOutputs,
+                                 const int* voiceIndices, int numVoices) noexcept
+{
+    jassert (numSamples <= preparedBlockSize);
+    numSamples = jmin (numSamples, preparedBlockSize);
+
+    if (numVoices <= 0 || numSamples <= 0)
+        return;
+
+    //a lane per rendered channel; output channel c takes channel min (c, numChannels - 1)
+    int numLanesUsed = 0;
+
+    for (int i = 0; i < numVoices; ++i)
+    {
+        auto voiceIndex = voiceIndices[i];
+        auto& voiceBuffer = *voiceBuffers.getUnchecked (voiceIndex);
+        auto& voiceOutput = voiceOutputs[voiceIndex];
+        auto numVoiceChannels = jlimit (1, maxChannels, jmin (voiceOutput.numChannels, voiceBuffer.getNumChannels()));
+
+        for (int channel = 0; channel < numVoiceChannels; ++channel)
+        {
+            auto& lane = lanes[numLanesUsed++];
+            lane.voiceIndex = voiceIndex;
+            lane.slot = voiceIndex * maxChannels + channel;
+            lane.source = voiceBuffer.getReadPointer (channel);
+
+            for (int outputChannel = 0; outputChannel < maxChannels; ++outputChannel)
+                lane.gains[outputChannel] = jmin (outputChannel, numVoiceChannels - 1) == channel
+                                              ? voiceOutput.gains[outputChannel] : 0.0f;
+        }
+    }
+
+    //the Q is stepped exactly as a voice's own filter would step it, once for the whole bank
+    smoothedQ.setTargetValue (getTargetQ());
+    numChunks = 0;
+
+    for (int pos = 0; pos < numSamples; ++numChunks)
+    {
+        auto numThisTime = smoothedQ.isSmoothing() ? jmin (subBlockSize, numSamples - pos)
+                                                   : numSamples - pos;
+        smoothedQ.skip (numThisTime);
+
+        chunkQ[numChunks] = smoothedQ.getCurrentValue();
+        chunkLength[numChunks] = numThisTime;
+        pos += numThisTime;
+    }
+
+    for (auto& mix : mixes)
+        FloatVectorOperations::clear (mix, numSamples);
+
+    //full groups of 16, then one narrower group padded with silent lanes
+    for (int done = 0; done < numLanesUsed;)
+    {
+        auto remaining = numLanesUsed - done;
+        auto numLanes = (int) VectorOps::width;
+
+        while (numLanes < maxLanes && numLanes < remaining)
+            numLanes *= 2;
+
+        auto numThisGroup = jmin (numLanes, remaining);
+        filterGroup (lanes + done, numThisGroup, numLanes, numSamples);
+        done += numThisGroup;
+    }
+
+    for (int channel = 0; channel < output.getNumChannels(); ++channel)
+        output.addFrom (channel, startSample, mixes[jmin (channel, maxChannels - 1)], numSamples);
+}
+
+void VoiceFilterBank::filterGroup (const Lane* groupLanes, int numUsed, int numLanes, int numSamples) noexcept
+{
+    auto z1Plane = states.get();
+    auto z2Plane = states + capacity * maxChannels;
+
+    //transpose the excitation into lane-interleaved frames; padding lanes stay silent
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        auto* dest = frames + lane;
+
+        if (lane < numUsed)
+        {
+            auto& source = groupLanes[lane];
+
+            for (int i = 0; i < numSamples; ++i, dest += numLanes)
+                *dest = source.source[i];
+
+            groupPlanes[z1][lane] = z1Plane[source.slot];
+            groupPlanes[z2][lane] = z2Plane[source.slot];
+            groupPlanes[gain0][lane] = source.gains[0];
+            groupPlanes[gain1][lane] = source.gains[1];
+        }
+        else
+        {
+            for (int i = 0; i < numSamples; ++i, dest += numLanes)
+                *dest = 0.0f;
+
+            for (int plane = 0; plane < numPlanes; ++plane)
+                groupPlanes[plane][lane] = 0.0f;
+        }
+    }
+
+    for (int chunk = 0, pos = 0; chunk < numChunks; pos += chunkLength[chunk++])
+    {
+        for (int lane = 0; lane < numUsed; ++lane)
+        {
+            auto voiceIndex = groupLanes[lane].voiceIndex;
+            float coefs[5];
+
+            //only runs the trig when the voice's note, the Q or the sample rate moved
+            if (coefficientCaches[voiceIndex].update (sampleRate, frequencies[voiceIndex], chunkQ[chunk], coefs))
+                for (int plane = b0; plane <= a2; ++plane)
+                    coefficients[plane * capacity + voiceIndex] = coefs[plane];
+
+            for (int plane = b0; plane <= a2; ++plane)
+                groupPlanes[plane][lane] = coefficients[plane * capacity + voiceIndex];
+        }
+
+        processBiquads (numLanes, groupPlanes, frames + pos * numLanes,
+                        mixes[0] + pos, mixes[1] + pos, chunkLength[chunk]);
+
+        //flushed at the end of each sub-block, as dsp::IIR::Filter does at the end of each call
+        for (int lane = 0; lane < numUsed; ++lane)
+        {
+            JUCE_SNAP_TO_ZERO (groupPlanes[z1][lane]);
+            JUCE_SNAP_TO_ZERO (groupPlanes[z2][lane]);
+        }
+    }
+
+    for (int lane = 0; lane < numUsed; ++lane)
+    {
+        z1Plane[groupLanes[lane].slot] = groupPlanes[z1][lane];
+        z2Plane[groupLanes[lane].slot] = groupPlanes[z2][lane];
+    }
+}
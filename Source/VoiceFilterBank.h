@@ -0,0 +1,105 @@
+/*
+    File: VoiceFilterBank.h
+    Description: The alternative to each voice running its own band-pass biquad. The bank keeps
+    every voice's filter coefficients and state in structure-of-arrays form, one plane per
+    coefficient or state variable, indexed by the voice's slot in the pool. After the voices have
+    rendered their raw excitation, the bank filters them together in groups of 16, 8 or 4, one
+    voice channel per SIMD lane, and pans the results straight into the output.
+
+    A single biquad is bound by the latency of its feedback path, so the per-voice filters leave
+    most of the CPU's SIMD width idle; running independent voices side by side fills it.
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BandPassCoefficientCache.h"
+#include "ParallelSynthesiser.h"
+#include "SynthParameters.h"
+
+//==============================================================================
+class VoiceFilterBank   : public ParallelSynthesiser::VoiceMixer
+{
+public:
+    //while Q glides, coefficients are recomputed every this many samples
+    static constexpr int subBlockSize = 32;
+
+    //the widest group filtered together
+    static constexpr int maxLanes = 16;
+
+    //storage for voice slots 0 to capacity - 1 is allocated up front, so voices can be added
+    //and removed without the bank ever reallocating
+    explicit VoiceFilterBank (int capacity);
+    ~VoiceFilterBank();
+
+    //sizes the scratch buffers, which only ever grow, so preparing again at a new rate and no
+    //larger a block doesn't allocate. call with the synth's lock held, never from the audio thread
+    void prepare (double sampleRate, int maximumBlockSize);
+
+    //the bank reads Q from here on the audio thread; set before the bank is first used
+    void setParameters (const SynthParameters& newParameters) noexcept     { parameters = &newParameters; }
+
+    //audio thread, between blocks. turning the bank on clears every voice's filter state
+    void setEnabled (bool shouldBeEnabled) noexcept;
+    bool isEnabled() const noexcept                                         { return enabled; }
+
+    //called by a voice when it starts a note: clears the slot's state and retunes it
+    void startVoice (int voiceIndex, double frequency) noexcept;
+
+    //the largest magnitude in a slot's filter state, across its channels; a rough measure of
+    //how loud the slot is still ringing
+    float getStateLevel (int voiceIndex) const noexcept;
+
+    //the Q the bank's filters are gliding to
+    float getTargetQ() const noexcept;
+
+    //ParallelSynthesiser::VoiceMixer. filters each channel a voice rendered and pans it into
+    //the output as its VoiceOutput says
+    void mixVoices (AudioBuffer<float>& output, int startSample, int numSamples,
+                    const OwnedArray<AudioBuffer<float>>& voiceBuffers,
+                    const ParallelSynthesiser::VoiceOutput* voiceOutputs,
+                    const int* voiceIndices, int numVoices) noexcept override;
+
+    //one group's lanes, gathered from the planes so the kernels can load them as vectors.
+    //gain0 and gain1 are what each lane adds to output channel 0 and to the channels above it
+    enum Plane { b0, b1, b2, a1, a2, z1, z2, gain0, gain1, numPlanes };
+    using GroupPlanes = float[numPlanes][maxLanes];
+
+private:
+    static constexpr int maxChannels = ParallelSynthesiser::VoiceOutput::maxChannels;
+
+    //one channel of one voice
+    struct Lane
+    {
+        int voiceIndex, slot;
+        const float* source;
+        float gains[maxChannels];
+    };
+
+    void filterGroup (const Lane* groupLanes, int numUsed, int numLanes, int numSamples) noexcept;
+
+    int capacity;
+    HeapBlock<float> coefficients;      //b0 to a2 for each voice, plane by plane
+    HeapBlock<float> states;            //z1 and z2 for each voice channel, plane by plane
+    HeapBlock<double> frequencies;
+    std::unique_ptr<BandPassCoefficientCache[]> coefficientCaches;
+    HeapBlock<Lane> lanes;              //this block's voice channels
+
+    //the excitation of the group being filtered, lane-interleaved sample by sample
+    HeapBlock<float> frames;
+    HeapBlock<float> mixes[maxChannels];
+    GroupPlanes groupPlanes;
+
+    //the Q of each sub-block of the current block, shared by every group
+    HeapBlock<float> chunkQ;
+    HeapBlock<int> chunkLength;
+    int numChunks = 0;
+
+    SmoothedValue<float, ValueSmoothingTypes::Multiplicative> smoothedQ;
+    const SynthParameters* parameters = nullptr;
+    double sampleRate = 44100.0;
+    int preparedBlockSize = 0, allocatedBlockSize = 0;
+    bool enabled = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VoiceFilterBank)
+};
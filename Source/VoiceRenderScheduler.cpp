@@ -0,0 +1,195 @@
+/*
+    File: VoiceRenderScheduler.cpp
+    Description: See VoiceRenderScheduler.h
+*/
+
+#include "VoiceRenderScheduler.h"
+
+#if JUCE_INTEL
+ #include <emmintrin.h>
+#else
+ #include <thread>
+#endif
+
+namespace
+{
+    //one step of a busy wait: tells the core it is spinning, so it saves power and doesn't starve
+    //a hyperthread sibling that may be the one rendering
+    inline void spinPause() noexcept
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #elif JUCE_ARM && defined (__aarch64__) && ! JUCE_MSVC
+        asm volatile ("yield");
+       #else
+        std::this_thread::yield();
+       #endif
+    }
+}
+
+//==============================================================================
+class VoiceRenderScheduler::Worker   : public Thread
+{
+public:
+    Worker (VoiceRenderScheduler& s, int index)
+        : Thread ("Voice render " + String (index)),
+          scheduler (s),
+          participantIndex (index),
+          lastGeneration (s.generation.load())
+    {
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            //blocks arrive one buffer period apart, so spin briefly before going to sleep
+            for (int spin = 0; spin < spinsBeforeSleeping && scheduler.generation.load() == lastGeneration; ++spin)
+            {
+                if (threadShouldExit())
+                    return;
+
+                spinPause();
+            }
+
+            if (scheduler.generation.load() == lastGeneration)
+                wakeUp.wait (100);
+
+            //a timeout with no new block touches nothing
+            auto current = scheduler.generation.load();
+
+            if (current == lastGeneration)
+                continue;
+
+            lastGeneration = current;
+
+            //joining the block's slot and then checking the block is still the current one is
+            //what lets perform() know when no worker can still be looking at a slot it is about
+            //to refill. a worker that wakes after the caller has moved on stays out
+            auto& slot = scheduler.slots[current & 1];
+            ++slot.numJoined;
+
+            if (scheduler.generation.load() == current)
+                scheduler.participate (participantIndex, current);
+
+            --slot.numJoined;
+        }
+    }
+
+    WaitableEvent wakeUp;
+
+private:
+    static constexpr int spinsBeforeSleeping = 4000;
+
+    VoiceRenderScheduler& scheduler;
+    const int participantIndex;
+    uint32 lastGeneration;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Worker)
+};
+
+//==============================================================================
+VoiceRenderScheduler::VoiceRenderScheduler() {}
+
+VoiceRenderScheduler::~VoiceRenderScheduler()
+{
+    stopWorkers();
+}
+
+void VoiceRenderScheduler::setOptions (const Options& newOptions)
+{
+    stopWorkers();
+
+    options = newOptions;
+    options.numWorkers = jlimit (0, maxParticipants - 1, options.numWorkers);
+
+    auto numCores = jlimit (1, 32, SystemStats::getNumCpus());
+
+    for (int i = 0; i < options.numWorkers; ++i)
+    {
+        auto* worker = workers.add (new Worker (*this, i + 1));
+
+        if (options.pinToCores && numCores > 1)
+            worker->setAffinityMask (1u << ((i + 1) % numCores));
+
+        worker->startThread (options.priority);
+    }
+}
+
+void VoiceRenderScheduler::stopWorkers()
+{
+    for (auto* worker : workers)
+    {
+        worker->signalThreadShouldExit();
+        worker->wakeUp.signal();
+    }
+
+    for (auto* worker : workers)
+        worker->stopThread (1000);
+
+    workers.clear();
+}
+
+//==============================================================================
+void VoiceRenderScheduler::perform (Job& job, int numTasks) noexcept
+{
+    if (numTasks <= 0)
+        return;
+
+    auto nextGeneration = generation.load() + 1;
+    auto& slot = slots[nextGeneration & 1];
+    auto numParticipants = jmin (workers.size() + 1, numTasks);
+
+    //a worker that joined this slot two blocks ago, as that block was finishing, may still be
+    //walking its exhausted ranges
+    while (slot.numJoined.load() > 0)
+        spinPause();
+
+    //contiguous ranges keep a voice on the same core from block to block unless it gets stolen
+    slot.numParticipants = numParticipants;
+
+    for (int i = 0; i < numParticipants; ++i)
+    {
+        slot.ranges[i].next = numTasks * i / numParticipants;
+        slot.ranges[i].end = numTasks * (i + 1) / numParticipants;
+    }
+
+    currentJob = &job;
+    tasksPending = numTasks;
+    generation = nextGeneration;
+
+    //the one place the audio thread locks: signal() takes the worker's event mutex
+    for (int i = 0; i < numParticipants - 1; ++i)
+        workers.getUnchecked (i)->wakeUp.signal();
+
+    participate (0, nextGeneration);
+
+    //every task claimed has finished; workers still in participate() can only find the ranges
+    //empty, and hold the slot until they leave it
+    while (tasksPending.load() > 0)
+        spinPause();
+}
+
+void VoiceRenderScheduler::participate (int participantIndex, uint32 generationToRun) noexcept
+{
+    auto& slot = slots[generationToRun & 1];
+    auto numParticipants = slot.numParticipants;
+    auto* job = currentJob.load();
+
+    //drain our own range first, then walk the others and steal whatever is left
+    for (int i = 0; i < numParticipants; ++i)
+    {
+        auto& range = slot.ranges[(participantIndex + i) % numParticipants];
+
+        for (;;)
+        {
+            auto task = range.next.fetch_add (1);
+
+            if (task >= range.end)
+                break;
+
+            job->runTask (task);
+            --tasksPending;
+        }
+    }
+}
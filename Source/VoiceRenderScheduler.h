@@ -0,0 +1,79 @@
+/*
+    File: VoiceRenderScheduler.h
+    Description: A small pool of real-time worker threads that share the tasks of one audio block
+    with the calling (audio) thread. Each participant gets a contiguous range of the tasks and
+    claims from it with an atomic counter; once its own range is empty it steals from the others,
+    so sharing out the tasks takes no lock. Only waking the workers does, see perform().
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class VoiceRenderScheduler
+{
+public:
+    struct Options
+    {
+        int numWorkers = 0;         //threads besides the caller; 0 runs everything on the caller
+        bool pinToCores = true;     //pins worker n to core n + 1, leaving core 0 to the device
+        int priority = 10;          //juce::Thread priority, 10 asks for real-time scheduling
+    };
+
+    //something with independent tasks, e.g. one per active voice
+    struct Job
+    {
+        virtual ~Job() {}
+        virtual void runTask (int taskIndex) = 0;
+    };
+
+    VoiceRenderScheduler();
+    ~VoiceRenderScheduler();
+
+    //restarts the pool; call from the message thread while audio is stopped
+    void setOptions (const Options& newOptions);
+    const Options& getOptions() const noexcept      { return options; }
+    int getNumWorkers() const noexcept              { return workers.size(); }
+
+    //runs job.runTask (0 .. numTasks - 1) across the caller and the workers and returns once
+    //every task has finished. never allocates. it does lock, once per worker it needs: each is
+    //woken with WaitableEvent::signal(), which takes the event's mutex to set its flag and notify
+    //its condition variable. the mutex is otherwise only held by that worker, briefly, as it goes
+    //to sleep or wakes, so the caller can wait on it but only for that long
+    void perform (Job& job, int numTasks) noexcept;
+
+    static constexpr int maxParticipants = 64;
+
+private:
+    class Worker;
+
+    struct TaskRange
+    {
+        std::atomic<int> next { 0 };
+        int end = 0;
+    };
+
+    //blocks alternate between two sets of ranges, so a worker that wakes late for the previous
+    //block only ever sees fully claimed ranges while the caller fills in the next ones. the
+    //caller waits for the workers that joined a slot to leave it before filling it again
+    struct Slot
+    {
+        TaskRange ranges[maxParticipants];
+        int numParticipants = 0;
+        std::atomic<int> numJoined { 0 };
+    };
+
+    void participate (int participantIndex, uint32 generationToRun) noexcept;
+    void stopWorkers();
+
+    Options options;
+    OwnedArray<Worker> workers;
+    Slot slots[2];
+    std::atomic<Job*> currentJob { nullptr };
+
+    std::atomic<uint32> generation { 0 };
+    std::atomic<int> tasksPending { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VoiceRenderScheduler)
+};
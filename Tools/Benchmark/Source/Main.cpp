@@ -0,0 +1,640 @@
+/*
+    File: Main.cpp
+    Description: Headless benchmarks for the voice and filter hot paths. Every case is timed over
+    repeated blocks and reported as nanoseconds per sample (or per call for the coefficient
+    cases), how many voices one core could render in real time at 48 kHz, and heap allocations
+    per block. Results can be saved as a JSON baseline and checked against on a later build.
+
+    Usage: Benchmark [--filter <text>] [--min-time 1] [--repetitions 3] [--json results.json]
+                     [--baseline baseline.json] [--tolerance 10]
+*/
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../../../Source/SynthEngine.h"
+
+#include <iostream>
+#include <iomanip>
+
+namespace
+{
+    constexpr double benchmarkSampleRate = 48000.0;
+    constexpr int synthBlockSize = 512;
+
+    struct BenchmarkOptions
+    {
+        String filter;
+        double minSeconds = 1.0;
+        int repetitions = 3;
+        File jsonOutput, baseline;
+        double tolerancePercent = 10.0;
+    };
+
+    struct Case
+    {
+        String name;
+        int samplesPerIteration = 0;    //0 times each iteration as one call instead
+        int voicesPerIteration = 0;     //0 if voices-per-core means nothing for the case
+        std::function<void (int numIterations)> run;
+    };
+
+    struct Result
+    {
+        String name;
+        int64 iterations = 0;
+        double nanoseconds = 0.0;       //per sample, or per call
+        bool perSample = true;
+        double voicesPerCore = 0.0;
+        double allocationsPerBlock = 0.0;
+    };
+
+    void printUsage()
+    {
+        std::cout << "Usage: Benchmark [options]" << std::endl
+                  << "  --filter <text>       only run cases whose name contains the text" << std::endl
+                  << "  --min-time <seconds>  time spent measuring each case (default 1)" << std::endl
+                  << "  --repetitions <n>     runs per case; the median is reported (default 3)" << std::endl
+                  << "  --json <file>         write the results as a JSON baseline" << std::endl
+                  << "  --baseline <file>     compare against an earlier --json file" << std::endl
+                  << "  --tolerance <percent> slowdown that counts as a regression (default 10)" << std::endl;
+    }
+
+    bool parseOptions (const StringArray& args, BenchmarkOptions& options, String& error)
+    {
+        for (int i = 0; i < args.size(); ++i)
+        {
+            auto arg = args[i];
+
+            if (i + 1 >= args.size())
+            {
+                error = "Missing value for " + arg;
+                return false;
+            }
+
+            auto value = args[++i];
+
+            if      (arg == "--filter")       options.filter = value;
+            else if (arg == "--min-time")     options.minSeconds = value.getDoubleValue();
+            else if (arg == "--repetitions")  options.repetitions = value.getIntValue();
+            else if (arg == "--json")         options.jsonOutput = File::getCurrentWorkingDirectory().getChildFile (value);
+            else if (arg == "--baseline")     options.baseline = File::getCurrentWorkingDirectory().getChildFile (value);
+            else if (arg == "--tolerance")    options.tolerancePercent = value.getDoubleValue();
+            else
+            {
+                error = "Unknown option " + arg;
+                return false;
+            }
+        }
+
+        if (options.minSeconds <= 0.0 || options.repetitions <= 0)
+            error = "Minimum time and repetitions must be positive";
+        else if (options.baseline != File() && ! options.baseline.existsAsFile())
+            error = "Can't find " + options.baseline.getFullPathName();
+
+        return error.isEmpty();
+    }
+
+    //==============================================================================
+    //held notes never reach their release, so every block renders the full voice path
+    EnvelopeGenerator::Parameters getHeldEnvelope()
+    {
+        EnvelopeGenerator::Parameters envelope;
+        envelope.attack = 0.001f;
+        envelope.sustain = 1.0f;
+        return envelope;
+    }
+
+    struct VoiceFixture
+    {
+        VoiceFixture (int blockSize, const SynthParameters& parameters)
+            : buffer (CHANNELS, blockSize), numSamples (blockSize)
+        {
+            voice.setCurrentPlaybackSampleRate (benchmarkSampleRate);
+            voice.prepareToPlay (blockSize, CHANNELS, benchmarkSampleRate);
+            voice.setParameters (parameters);
+            voice.setEnvelopeParameters (getHeldEnvelope());
+            voice.startNote (69, 1.0f, nullptr, 0);
+        }
+
+        void render()
+        {
+            buffer.clear();
+            voice.renderNextBlock (buffer, 0, numSamples);
+        }
+
+        SynthVoice voice;
+        AudioBuffer<float> buffer;
+        int numSamples;
+    };
+
+    //one voice's excitation, without the envelope
+    struct NoiseFixture
+    {
+        NoiseFixture (int blockSize, NoiseGenerator::Colour colour)
+            : output ((size_t) blockSize)
+        {
+            noise.setColour (colour);
+        }
+
+        void process()
+        {
+            noise.process (output.data(), (int) output.size(), 0.5f, 1.0f);
+        }
+
+        NoiseGenerator noise;
+        std::vector<float> output;
+    };
+
+    //the filter processes the same noise block every time, out of place, so its state never
+    //settles into silence or denormals
+    struct BandPassFixture
+    {
+        using Duplicator = dsp::ProcessorDuplicator<dsp::IIR::Filter<float>, dsp::IIR::Coefficients<float>>;
+
+        BandPassFixture (int blockSize, float q)
+            : filter (dsp::IIR::Coefficients<float>::makeBandPass (benchmarkSampleRate, 440.0f, q)),
+              input (CHANNELS, blockSize), output (CHANNELS, blockSize)
+        {
+            filter.prepare ({ benchmarkSampleRate, (uint32) blockSize, (uint32) CHANNELS });
+
+            Random random (1);
+
+            for (int channel = 0; channel < CHANNELS; ++channel)
+                for (int i = 0; i < blockSize; ++i)
+                    input.setSample (channel, i, random.nextFloat() * 2.0f - 1.0f);
+        }
+
+        void process()
+        {
+            dsp::AudioBlock<float> inputBlock (input), outputBlock (output);
+            filter.process (dsp::ProcessContextNonReplacing<float> (inputBlock, outputBlock));
+        }
+
+        Duplicator filter;
+        AudioBuffer<float> input, output;
+    };
+
+    //one VoiceFilter channel, fed a fresh copy of the same noise block every time for the same
+    //reason; the copy is a small part of the cost
+    struct VoiceFilterFixture
+    {
+        VoiceFilterFixture (int blockSize, VoiceFilter::Topology topology, double q)
+            : input ((size_t) blockSize), output ((size_t) blockSize)
+        {
+            filter.setTopology (topology);
+            filter.prepare (benchmarkSampleRate);
+            filter.update (440.0, q);
+
+            Random random (1);
+
+            for (auto& sample : input)
+                sample = random.nextFloat() * 2.0f - 1.0f;
+        }
+
+        void process()
+        {
+            std::copy (input.begin(), input.end(), output.begin());
+            filter.process (0, output.data(), (int) output.size());
+        }
+
+        VoiceFilter filter;
+        std::vector<float> input, output;
+    };
+
+    //the whole device callback path, with the notes pushed into the MIDI queue the way the
+    //GUI's on-screen keyboard would
+    struct SynthFixture
+    {
+        SynthFixture (int numNotes, int blockSize, SynthAudioSource::FilterEngine filterEngine,
+                      SynthAudioSource::FilterTopology topology = SynthAudioSource::FilterTopology::biquad,
+                      int voiceRate = 1, bool multitimbral = false)
+            : source (jmax (1, numNotes)), buffer (CHANNELS, blockSize), numSamples (blockSize)
+        {
+            source.setFilterEngine (filterEngine);
+            source.setOversamplingFactor (voiceRate);
+            source.setMultitimbral (multitimbral);
+
+            //every part gets the same patch as the master
+            auto envelope = getHeldEnvelope();
+
+            for (int part = -1; part < (multitimbral ? SynthAudioSource::numParts : 0); ++part)
+            {
+                auto& parameters = part < 0 ? source.getParameters() : source.getPartParameters (part);
+                parameters.setValue (SynthParameters::filterType, (float) topology);
+                parameters.setValue (SynthParameters::volume, 1.0f);
+                parameters.setValue (SynthParameters::attack, envelope.attack);
+                parameters.setValue (SynthParameters::sustain, envelope.sustain);
+            }
+
+            source.prepareToPlay (blockSize, benchmarkSampleRate);
+
+            //96 notes from C1 per channel, so any count up to maxPolyphony gets distinct notes. the
+            //multi-timbral synth deals them out over all 16 parts instead
+            for (int i = 0; i < numNotes; ++i)
+            {
+                auto channel = multitimbral ? 1 + i % SynthAudioSource::numParts : 1 + i / 96;
+                source.getMidiQueue().push (MidiMessage::noteOn (channel, 24 + i % 96, 1.0f));
+            }
+
+            render();
+        }
+
+        void render()
+        {
+            source.getNextAudioBlock (AudioSourceChannelInfo (&buffer, 0, numSamples));
+        }
+
+        SynthAudioSource source;
+        AudioBuffer<float> buffer;
+        int numSamples;
+    };
+
+    //==============================================================================
+    std::vector<Case> createCases (const SynthParameters& parameters)
+    {
+        std::vector<Case> cases;
+
+        for (int blockSize = 32; blockSize <= 2048; blockSize *= 2)
+        {
+            auto fixture = std::make_shared<VoiceFixture> (blockSize, parameters);
+
+            cases.push_back ({ "VoiceRender/" + String (blockSize), blockSize, 1, [fixture] (int n)
+            {
+                for (int i = 0; i < n; ++i)
+                    fixture->render();
+            }});
+        }
+
+        {
+            //the coefficient cache answers without any trig while nothing has changed
+            auto fixture = std::make_shared<VoiceFixture> (synthBlockSize, parameters);
+
+            cases.push_back ({ "UpdateFilter/unchanged", 0, 0, [fixture] (int n)
+            {
+                for (int i = 0; i < n; ++i)
+                    fixture->voice.updateFilter();
+            }});
+        }
+
+        {
+            //what updateFilter costs on every step of a Q glide
+            auto cache = std::make_shared<BandPassCoefficientCache>();
+            auto coefficients = std::make_shared<std::array<float, 5>>();
+
+            cases.push_back ({ "UpdateFilter/recompute", 0, 0, [cache, coefficients] (int n)
+            {
+                for (int i = 0; i < n; ++i)
+                    cache->update (benchmarkSampleRate, 440.0, (i & 1) != 0 ? 4.0 : 4.01, coefficients->data());
+            }});
+        }
+
+        //the reference the cache replaced: allocates a new coefficients object per update
+        cases.push_back ({ "UpdateFilter/makeBandPass", 0, 0, [] (int n)
+        {
+            for (int i = 0; i < n; ++i)
+                dsp::IIR::Coefficients<float>::makeBandPass (benchmarkSampleRate, 440.0f, (i & 1) != 0 ? 4.0f : 4.01f);
+        }});
+
+        for (auto q : { 0.1f, 1.0f, 10.0f, 100.0f, 1000.0f })
+        {
+            auto fixture = std::make_shared<BandPassFixture> (synthBlockSize, q);
+
+            cases.push_back ({ "BandPass/Q:" + String (q), synthBlockSize, 0, [fixture] (int n)
+            {
+                for (int i = 0; i < n; ++i)
+                    fixture->process();
+            }});
+        }
+
+        using Colour = NoiseGenerator::Colour;
+
+        for (auto colour : { Colour::white, Colour::pink, Colour::blue })
+        {
+            auto fixture = std::make_shared<NoiseFixture> (synthBlockSize, colour);
+            String name (colour == Colour::white ? "white" : colour == Colour::pink ? "pink" : "blue");
+
+            cases.push_back ({ "Noise/" + name, synthBlockSize, 0, [fixture] (int n)
+            {
+                for (int i = 0; i < n; ++i)
+                    fixture->process();
+            }});
+        }
+
+        //each filter topology on its own, then inside 64 voices
+        using Topology = VoiceFilter::Topology;
+        const Topology topologies[] = { Topology::biquad, Topology::stateVariable, Topology::biquad4,
+                                        Topology::biquad8, Topology::ladder };
+
+        for (auto topology : topologies)
+        {
+            auto fixture = std::make_shared<VoiceFilterFixture> (synthBlockSize, topology, 4.0);
+
+            cases.push_back ({ "Filter/" + VoiceFilter::getTopologyName (topology), synthBlockSize, 0, [fixture] (int n)
+            {
+                for (int i = 0; i < n; ++i)
+                    fixture->process();
+            }});
+        }
+
+        for (auto topology : topologies)
+        {
+            auto fixture = std::make_shared<SynthFixture> (64, synthBlockSize, SynthAudioSource::FilterEngine::perVoice, topology);
+
+            cases.push_back ({ "SynthAudioSource/" + VoiceFilter::getTopologyName (topology) + "/notes:64", synthBlockSize, 64,
+                               [fixture] (int n)
+            {
+                for (int i = 0; i < n; ++i)
+                    fixture->render();
+            }});
+        }
+
+        for (auto numNotes : { 1, 8, 64, 256 })
+        {
+            auto fixture = std::make_shared<SynthFixture> (numNotes, synthBlockSize, SynthAudioSource::FilterEngine::perVoice);
+
+            cases.push_back ({ "SynthAudioSource/notes:" + String (numNotes), synthBlockSize, numNotes, [fixture] (int n)
+            {
+                for (int i = 0; i < n; ++i)
+                    fixture->render();
+            }});
+        }
+
+        //the same notes with the filters run across voices by the SIMD bank, then by the resonators
+        for (auto numNotes : { 1, 8, 64, 256 })
+        {
+            auto fixture = std::make_shared<SynthFixture> (numNotes, synthBlockSize, SynthAudioSource::FilterEngine::simdBank);
+
+            cases.push_back ({ "SynthAudioSource/bank/notes:" + String (numNotes), synthBlockSize, numNotes, [fixture] (int n)
+            {
+                for (int i = 0; i < n; ++i)
+                    fixture->render();
+            }});
+        }
+
+        //a resonator per distinct note, so with 256 voices over 96 notes most resonators take two or three
+        for (auto numNotes : { 1, 8, 64, 256 })
+        {
+            auto fixture = std::make_shared<SynthFixture> (numNotes, synthBlockSize, SynthAudioSource::FilterEngine::resonators);
+
+            cases.push_back ({ "SynthAudioSource/resonators/notes:" + String (numNotes), synthBlockSize, numNotes, [fixture] (int n)
+            {
+                for (int i = 0; i < n; ++i)
+                    fixture->render();
+            }});
+        }
+
+        //64 notes with the voices oversampled, decimation included
+        for (auto voiceRate : { 2, 4 })
+        {
+            auto fixture = std::make_shared<SynthFixture> (64, synthBlockSize, SynthAudioSource::FilterEngine::perVoice,
+                                                           SynthAudioSource::FilterTopology::biquad, voiceRate);
+
+            cases.push_back ({ "SynthAudioSource/rate:" + String (voiceRate) + "x/notes:64", synthBlockSize, 64,
+                               [fixture] (int n)
+            {
+                for (int i = 0; i < n; ++i)
+                    fixture->render();
+            }});
+        }
+
+        {
+            //64 notes over the 16 parts of the multi-timbral engine
+            auto fixture = std::make_shared<SynthFixture> (64, synthBlockSize, SynthAudioSource::FilterEngine::perVoice,
+                                                           SynthAudioSource::FilterTopology::biquad, 1, true);
+
+            cases.push_back ({ "SynthAudioSource/multitimbral/notes:64", synthBlockSize, 64, [fixture] (int n)
+            {
+                for (int i = 0; i < n; ++i)
+                    fixture->render();
+            }});
+        }
+
+        {
+            //64 notes with the pitch wheel moving every block, so every voice ramps its filter for
+            //a control interval each time
+            auto fixture = std::make_shared<SynthFixture> (64, synthBlockSize, SynthAudioSource::FilterEngine::perVoice);
+            auto& modulation = fixture->source.getModulationMatrix();
+            modulation.setRoute (0, { ModulationMatrix::Source::pitchBend, 0, ModulationMatrix::Destination::cutoff, 2.0f });
+            modulation.setRoute (1, { ModulationMatrix::Source::pitchBend, 0, ModulationMatrix::Destination::q, 1.0f });
+            auto wheel = std::make_shared<int> (0);
+
+            cases.push_back ({ "SynthAudioSource/modulated/notes:64", synthBlockSize, 64, [fixture, wheel] (int n)
+            {
+                for (int i = 0; i < n; ++i)
+                {
+                    *wheel = (*wheel + 1000) % 16384;
+                    fixture->source.getMidiQueue().push (MidiMessage::pitchWheel (1, *wheel));
+                    fixture->render();
+                }
+            }});
+        }
+
+        {
+            //nothing sounding: the synth should skip straight past rendering and mixing
+            auto fixture = std::make_shared<SynthFixture> (0, synthBlockSize, SynthAudioSource::FilterEngine::perVoice);
+
+            cases.push_back ({ "SynthAudioSource/idle", synthBlockSize, 0, [fixture] (int n)
+            {
+                for (int i = 0; i < n; ++i)
+                    fixture->render();
+            }});
+        }
+
+        return cases;
+    }
+
+    //==============================================================================
+    double timeIterations (const Case& benchmarkCase, int numIterations)
+    {
+        auto start = Time::getHighResolutionTicks();
+        benchmarkCase.run (numIterations);
+        return Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - start);
+    }
+
+    Result measure (const Case& benchmarkCase, const BenchmarkOptions& options)
+    {
+        //one untimed pass warms the caches and lets anything lazy settle
+        benchmarkCase.run (1);
+
+        //doubles the batch until it is long enough for the clock, then sizes each repetition
+        int numIterations = 1;
+        auto seconds = timeIterations (benchmarkCase, numIterations);
+
+        while (seconds < 0.01 && numIterations < (1 << 28))
+        {
+            numIterations *= 2;
+            seconds = timeIterations (benchmarkCase, numIterations);
+        }
+
+        auto secondsPerRepetition = options.minSeconds / options.repetitions;
+        numIterations = (int) jlimit (1.0, (double) (1 << 30),
+                                      std::ceil (numIterations * secondsPerRepetition / jmax (seconds, 1.0e-9)));
+
+        auto unitsPerIteration = (double) jmax (1, benchmarkCase.samplesPerIteration);
+        std::vector<double> nanoseconds;
+        auto allocationsBefore = AllocationCounter::getCount();
+
+        for (int i = 0; i < options.repetitions; ++i)
+            nanoseconds.push_back (timeIterations (benchmarkCase, numIterations) * 1.0e9
+                                    / (numIterations * unitsPerIteration));
+
+        auto allocations = AllocationCounter::getCount() - allocationsBefore;
+        std::sort (nanoseconds.begin(), nanoseconds.end());
+
+        Result result;
+        result.name = benchmarkCase.name;
+        result.iterations = (int64) numIterations * options.repetitions;
+        result.nanoseconds = nanoseconds[nanoseconds.size() / 2];
+        result.perSample = benchmarkCase.samplesPerIteration > 0;
+        result.allocationsPerBlock = (double) allocations / (double) result.iterations;
+
+        if (benchmarkCase.voicesPerIteration > 0 && result.nanoseconds > 0.0)
+        {
+            auto nanosecondsPerVoiceSample = result.nanoseconds / benchmarkCase.voicesPerIteration;
+            result.voicesPerCore = 1.0e9 / (nanosecondsPerVoiceSample * benchmarkSampleRate);
+        }
+
+        return result;
+    }
+
+    //==============================================================================
+    void printHeader()
+    {
+        std::cout << std::left << std::setw (32) << "Benchmark"
+                  << std::right << std::setw (14) << "ns/sample"
+                  << std::setw (18) << "voices/core@48k"
+                  << std::setw (14) << "allocs/block"
+                  << std::setw (14) << "iterations" << std::endl
+                  << String::repeatedString ("-", 92) << std::endl;
+    }
+
+    void printResult (const Result& result)
+    {
+        auto time = String (result.nanoseconds, 2) + (result.perSample ? "" : " /call");
+        auto voices = result.voicesPerCore > 0.0 ? String (result.voicesPerCore, 1) : String ("-");
+        auto allocations = AllocationCounter::isAvailable() ? String (result.allocationsPerBlock, 2) : String ("n/a");
+
+        std::cout << std::left << std::setw (32) << result.name
+                  << std::right << std::setw (14) << time
+                  << std::setw (18) << voices
+                  << std::setw (14) << allocations
+                  << std::setw (14) << result.iterations << std::endl;
+    }
+
+    var toJSON (const Array<Result>& results)
+    {
+        Array<var> benchmarks;
+
+        for (auto& result : results)
+        {
+            auto* object = new DynamicObject();
+            object->setProperty ("name", result.name);
+            object->setProperty ("unit", result.perSample ? "sample" : "call");
+            object->setProperty ("nanoseconds", result.nanoseconds);
+            object->setProperty ("voicesPerCore", result.voicesPerCore);
+            object->setProperty ("allocationsPerBlock", result.allocationsPerBlock);
+            object->setProperty ("iterations", result.iterations);
+            benchmarks.add (var (object));
+        }
+
+        auto* root = new DynamicObject();
+        var json (root);
+        root->setProperty ("sampleRate", benchmarkSampleRate);
+        root->setProperty ("date", Time::getCurrentTime().toISO8601 (true));
+        root->setProperty ("cpu", SystemStats::getCpuVendor());
+        root->setProperty ("cpuSpeedMHz", SystemStats::getCpuSpeedInMegahertz());
+        root->setProperty ("allocationsCounted", AllocationCounter::isAvailable());
+        root->setProperty ("benchmarks", benchmarks);
+        return json;
+    }
+
+    //prints the change for every case in both runs; returns false if any got slower than the
+    //tolerance or started allocating
+    bool compareWithBaseline (const Array<Result>& results, const File& baselineFile, double tolerancePercent)
+    {
+        auto baseline = JSON::parse (baselineFile);
+
+        if (! baseline.isObject() || ! baseline["benchmarks"].isArray())
+        {
+            std::cerr << "Can't parse " << baselineFile.getFullPathName() << std::endl;
+            return false;
+        }
+
+        bool passed = true;
+        std::cout << std::endl << "Against " << baselineFile.getFileName()
+                  << " (" << baseline["date"].toString() << ")" << std::endl;
+
+        for (auto& old : *baseline["benchmarks"].getArray())
+        {
+            auto name = old["name"].toString();
+            auto* result = std::find_if (results.begin(), results.end(),
+                                         [&name] (const Result& r) { return r.name == name; });
+
+            if (result == results.end())
+                continue;
+
+            auto oldNanoseconds = (double) old["nanoseconds"];
+            auto change = oldNanoseconds > 0.0 ? (result->nanoseconds / oldNanoseconds - 1.0) * 100.0 : 0.0;
+            auto startedAllocating = (double) old["allocationsPerBlock"] == 0.0 && result->allocationsPerBlock > 0.0;
+            auto regressed = change > tolerancePercent || startedAllocating;
+            passed = passed && ! regressed;
+
+            std::cout << std::left << std::setw (32) << name
+                      << std::right << std::setw (14) << ((change >= 0.0 ? "+" : "") + String (change, 1) + "%")
+                      << (startedAllocating ? "  now allocates" : "")
+                      << (regressed ? "  REGRESSION" : "") << std::endl;
+        }
+
+        return passed;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    StringArray args;
+
+    for (int i = 1; i < argc; ++i)
+        args.add (argv[i]);
+
+    BenchmarkOptions options;
+    String error;
+
+    if (! parseOptions (args, options, error))
+    {
+        std::cerr << error << std::endl;
+        printUsage();
+        return 1;
+    }
+
+    SynthParameters parameters;
+    parameters.prepare (benchmarkSampleRate);
+
+    Array<Result> results;
+    printHeader();
+
+    for (auto& benchmarkCase : createCases (parameters))
+    {
+        if (options.filter.isNotEmpty() && ! benchmarkCase.name.containsIgnoreCase (options.filter))
+            continue;
+
+        auto result = measure (benchmarkCase, options);
+        printResult (result);
+        results.add (result);
+    }
+
+    if (options.jsonOutput != File())
+    {
+        if (! options.jsonOutput.replaceWithText (JSON::toString (toJSON (results))))
+        {
+            std::cerr << "Can't write " << options.jsonOutput.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        std::cout << std::endl << "Wrote " << options.jsonOutput.getFullPathName() << std::endl;
+    }
+
+    if (options.baseline != File() && ! compareWithBaseline (results, options.baseline, options.tolerancePercent))
+        return 2;
+
+    return 0;
+}
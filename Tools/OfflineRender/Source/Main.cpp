@@ -0,0 +1,766 @@
+/*
+    File: Main.cpp
+    Description: Headless offline renderer. Reads a Standard MIDI File, drives SynthAudioSource
+    directly with no audio device and writes the result to WAV or FLAC as fast as the CPU allows.
+
+    Usage: OfflineRender --input song.mid --output song.wav [--sample-rate 48000] [--block-size 512]
+                         [--polyphony 8] [--stealing oldest] [--threads 0] [--q 1] [--gain 1]
+                         [--clip hard] [--oversample 0] [--filter voice] [--topology biquad]
+                         [--spread 0] [--pan-law balanced] [--stereo-noise 0] [--min-sub-block 16]
+                         [--voice-rate 1] [--noise white] [--seed 0] [--cache dir] [--cache-memory 256]
+                         [--multitimbral 0] [--part 2:q=8,release=1] [--part-voices 2:4] [--mod bend:cutoff=2]
+                         [--control-interval 32] [--velocity-curve linear] [--velocity-points 0:0,127:1]
+                         [--velocity-q 0] [--bits 24] [--tail 2]
+*/
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../../../Source/SynthEngine.h"
+#include "../../../Source/NoteRenderer.h"
+#include "../../../Source/RenderCache.h"
+
+#include <iostream>
+
+namespace
+{
+    //one --part value: a parameter of the part for a MIDI channel
+    struct PartSetting
+    {
+        int partIndex;
+        int parameterIndex;
+        float value;
+    };
+
+    struct RenderOptions
+    {
+        File input, output;
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        int polyphony = SynthAudioSource::defaultPolyphony;
+        SynthAudioSource::StealingPolicy stealingPolicy = SynthAudioSource::StealingPolicy::oldest;
+        int threads = 0;
+        int bitsPerSample = 24;
+        double q = 1.0;
+        float gain = 1.0f;
+        OutputStage::ClipMode clipMode = OutputStage::ClipMode::hard;
+        bool oversample = false;
+        SynthAudioSource::FilterEngine filterEngine = SynthAudioSource::FilterEngine::perVoice;
+        SynthAudioSource::FilterTopology topology = SynthAudioSource::FilterTopology::biquad;
+        float spread = 0.0f;
+        SynthAudioSource::PanLaw panLaw = SynthAudioSource::PanLaw::balanced;
+        bool stereoNoise = false;
+        int minimumSubBlockSize = SynthAudioSource::defaultMinimumSubBlockSize;
+        int voiceRate = 1;
+        SynthAudioSource::NoiseColour noiseColour = SynthAudioSource::NoiseColour::white;
+        uint32 seed = 0;
+        bool useCache = false;
+        File cacheDirectory;            //File() keeps the cache in memory only
+        int cacheMemoryMegabytes = 256;
+        bool multitimbral = false;
+        std::vector<PartSetting> partSettings;
+        int partVoiceLimits[SynthAudioSource::numParts];
+        std::vector<ModulationMatrix::Route> modulationRoutes;
+        int controlInterval = SynthAudioSource::defaultControlInterval;
+        VelocityCurve::Shape velocityCurve = VelocityCurve::Shape::linear;
+        Array<VelocityCurve::CurvePoint> velocityPoints;
+        float velocityQ = 0.0f;
+        double tailSeconds = 2.0;
+
+        RenderOptions()
+        {
+            std::fill (std::begin (partVoiceLimits), std::end (partVoiceLimits), (int) SynthAudioSource::maxPolyphony);
+        }
+    };
+
+    void printUsage()
+    {
+        std::cout << "Usage: OfflineRender --input <file.mid> --output <file.wav|file.flac> [options]" << std::endl
+                  << "  --sample-rate <hz>    output sample rate (default 48000)" << std::endl
+                  << "  --block-size <n>      samples rendered per block (default 512)" << std::endl
+                  << "  --polyphony <n>       number of voices, up to " << SynthAudioSource::maxPolyphony
+                                                 << " (default " << SynthAudioSource::defaultPolyphony << ")" << std::endl
+                  << "  --stealing <policy>   oldest, quietest, lowest or releasing (default oldest)" << std::endl
+                  << "  --threads <n>         extra voice render threads, 0 renders serially (default 0)" << std::endl
+                  << "  --q <value>           band-pass Q (default 1)" << std::endl
+                  << "  --gain <value>        output gain before clipping (default 1)" << std::endl
+                  << "  --clip <mode>         hard, tanh or cubic (default hard)" << std::endl
+                  << "  --oversample <0|1>    run the clipper at twice the sample rate (default 0)" << std::endl
+                  << "  --filter <engine>     voice (a filter per voice), bank (SIMD across voices) or resonators" << std::endl
+                  << "                        (one per note, shared by its voices) (default voice)" << std::endl
+                  << "  --topology <type>     biquad, svf, biquad4, biquad8 or ladder (default biquad)" << std::endl
+                  << "  --spread <0..1>       pans notes by pitch, low to the left (default 0)" << std::endl
+                  << "  --pan-law <law>       balanced, power or linear (default balanced)" << std::endl
+                  << "  --stereo-noise <0|1>  independent noise per channel instead of mono (default 0)" << std::endl
+                  << "  --min-sub-block <n>   fewest samples rendered between two note events (default "
+                  << SynthAudioSource::defaultMinimumSubBlockSize << ")" << std::endl
+                  << "  --voice-rate <1|2|4>  run the voices at this multiple of the sample rate (default 1)" << std::endl
+                  << "  --noise <colour>      white, pink or blue (default white)" << std::endl
+                  << "  --seed <n>            noise seed; the same seed renders the same file (default 0)" << std::endl
+                  << "  --cache <dir|memory>  render each distinct note once and mix the cached copies, keeping" << std::endl
+                  << "                        them in dir for later runs, or only in memory (default off)" << std::endl
+                  << "  --cache-memory <mb>   how much of the cache stays in memory (default 256)" << std::endl
+                  << "  --multitimbral <0|1>  every MIDI channel plays its own part, starting out as the patch" << std::endl
+                  << "                        set by the options above (default 0)" << std::endl
+                  << "  --part <ch>:<id>=<v>  sets parameters of channel ch's part, e.g. 10:q=2,release=0.5;" << std::endl
+                  << "                        the ids are volume, q, attack, decay, sustain, release, spread," << std::endl
+                  << "                        filterType, noiseColour, velocityCurve and velocityQ. can be repeated" << std::endl
+                  << "  --part-voices <ch>:<n> the most voices channel ch's part may hold, 0 mutes it" << std::endl
+                  << "  --mod <src>:<dst>=<v> routes bend, pressure, aftertouch or cc<n> to cutoff (semitones)," << std::endl
+                  << "                        q (octaves) or level (dB) by v at full scale, e.g. cc1:q=2; up to "
+                  << ModulationMatrix::numSlots << std::endl
+                  << "  --control-interval <n> samples between filter updates while Q or a modulation moves (default "
+                  << SynthAudioSource::defaultControlInterval << ")" << std::endl
+                  << "  --velocity-curve <c>  linear, exponential or custom: how velocity sets a note's level" << std::endl
+                  << "                        (default linear)" << std::endl
+                  << "  --velocity-points <p> the custom curve, <velocity>:<gain>,... e.g. 0:0,64:0.2,127:1" << std::endl
+                  << "  --velocity-q <oct>    octaves of Q added at full velocity, negative widens (default 0)" << std::endl
+                  << "  --bits <n>            bits per sample, 16 or 24 (default 24)" << std::endl
+                  << "  --tail <seconds>      extra time rendered after the last event (default 2)" << std::endl;
+    }
+
+    bool parseStealingPolicy (const String& name, SynthAudioSource::StealingPolicy& policy)
+    {
+        using Policy = SynthAudioSource::StealingPolicy;
+
+        if      (name == "oldest")     policy = Policy::oldest;
+        else if (name == "quietest")   policy = Policy::quietest;
+        else if (name == "lowest")     policy = Policy::lowestNote;
+        else if (name == "releasing")  policy = Policy::releasingFirst;
+        else                           return false;
+
+        return true;
+    }
+
+    bool parseClipMode (const String& name, OutputStage::ClipMode& mode)
+    {
+        if      (name == "hard")   mode = OutputStage::ClipMode::hard;
+        else if (name == "tanh")   mode = OutputStage::ClipMode::tanh;
+        else if (name == "cubic")  mode = OutputStage::ClipMode::cubic;
+        else                       return false;
+
+        return true;
+    }
+
+    bool parseFilterEngine (const String& name, SynthAudioSource::FilterEngine& engine)
+    {
+        if      (name == "voice")       engine = SynthAudioSource::FilterEngine::perVoice;
+        else if (name == "bank")        engine = SynthAudioSource::FilterEngine::simdBank;
+        else if (name == "resonators")  engine = SynthAudioSource::FilterEngine::resonators;
+        else                            return false;
+
+        return true;
+    }
+
+    bool parseTopology (const String& name, SynthAudioSource::FilterTopology& topology)
+    {
+        using Topology = SynthAudioSource::FilterTopology;
+
+        for (auto candidate : { Topology::biquad, Topology::stateVariable, Topology::biquad4, Topology::biquad8, Topology::ladder })
+        {
+            if (name == VoiceFilter::getTopologyName (candidate))
+            {
+                topology = candidate;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool parsePanLaw (const String& name, SynthAudioSource::PanLaw& law)
+    {
+        if      (name == "balanced")  law = SynthAudioSource::PanLaw::balanced;
+        else if (name == "power")     law = SynthAudioSource::PanLaw::constantPower;
+        else if (name == "linear")    law = SynthAudioSource::PanLaw::linear;
+        else                          return false;
+
+        return true;
+    }
+
+    bool parseNoiseColour (const String& name, SynthAudioSource::NoiseColour& colour)
+    {
+        if      (name == "white")  colour = SynthAudioSource::NoiseColour::white;
+        else if (name == "pink")   colour = SynthAudioSource::NoiseColour::pink;
+        else if (name == "blue")   colour = SynthAudioSource::NoiseColour::blue;
+        else                       return false;
+
+        return true;
+    }
+
+    bool parseVelocityCurve (const String& name, VelocityCurve::Shape& shape)
+    {
+        using Shape = VelocityCurve::Shape;
+
+        for (auto candidate : { Shape::linear, Shape::exponential, Shape::custom })
+        {
+            if (name == VelocityCurve::getShapeName (candidate))
+            {
+                shape = candidate;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    //"<channel>:<rest>", channel 1 to 16
+    bool parsePartPrefix (const String& value, int& partIndex, String& rest)
+    {
+        if (! value.containsChar (':'))
+            return false;
+
+        partIndex = value.upToFirstOccurrenceOf (":", false, false).getIntValue() - 1;
+        rest = value.fromFirstOccurrenceOf (":", false, false);
+
+        return isPositiveAndBelow (partIndex, SynthAudioSource::numParts) && rest.isNotEmpty();
+    }
+
+    bool parsePartSettings (const String& value, std::vector<PartSetting>& settings)
+    {
+        int partIndex;
+        String rest;
+
+        if (! parsePartPrefix (value, partIndex, rest))
+            return false;
+
+        for (auto& assignment : StringArray::fromTokens (rest, ",", {}))
+        {
+            auto parameterIndex = SynthParameters::getIndexForID (assignment.upToFirstOccurrenceOf ("=", false, false).trim());
+
+            if (parameterIndex < 0 || ! assignment.containsChar ('='))
+                return false;
+
+            settings.push_back ({ partIndex, parameterIndex,
+                                  assignment.fromFirstOccurrenceOf ("=", false, false).getFloatValue() });
+        }
+
+        return true;
+    }
+
+    bool parseOptions (const StringArray& args, RenderOptions& options, String& error)
+    {
+        for (int i = 0; i < args.size(); ++i)
+        {
+            auto arg = args[i];
+
+            if (i + 1 >= args.size())
+            {
+                error = "Missing value for " + arg;
+                return false;
+            }
+
+            auto value = args[++i];
+
+            if      (arg == "--input")        options.input = File::getCurrentWorkingDirectory().getChildFile (value);
+            else if (arg == "--output")       options.output = File::getCurrentWorkingDirectory().getChildFile (value);
+            else if (arg == "--sample-rate")  options.sampleRate = value.getDoubleValue();
+            else if (arg == "--block-size")   options.blockSize = value.getIntValue();
+            else if (arg == "--polyphony")    options.polyphony = value.getIntValue();
+            else if (arg == "--stealing")
+            {
+                if (! parseStealingPolicy (value, options.stealingPolicy))
+                {
+                    error = "Unknown stealing policy " + value;
+                    return false;
+                }
+            }
+            else if (arg == "--threads")      options.threads = value.getIntValue();
+            else if (arg == "--q")            options.q = value.getDoubleValue();
+            else if (arg == "--gain")         options.gain = value.getFloatValue();
+            else if (arg == "--oversample")   options.oversample = value.getIntValue() != 0;
+            else if (arg == "--clip")
+            {
+                if (! parseClipMode (value, options.clipMode))
+                {
+                    error = "Unknown clip mode " + value;
+                    return false;
+                }
+            }
+            else if (arg == "--filter")
+            {
+                if (! parseFilterEngine (value, options.filterEngine))
+                {
+                    error = "Unknown filter engine " + value;
+                    return false;
+                }
+            }
+            else if (arg == "--topology")
+            {
+                if (! parseTopology (value, options.topology))
+                {
+                    error = "Unknown filter topology " + value;
+                    return false;
+                }
+            }
+            else if (arg == "--spread")       options.spread = value.getFloatValue();
+            else if (arg == "--pan-law")
+            {
+                if (! parsePanLaw (value, options.panLaw))
+                {
+                    error = "Unknown pan law " + value;
+                    return false;
+                }
+            }
+            else if (arg == "--stereo-noise") options.stereoNoise = value.getIntValue() != 0;
+            else if (arg == "--min-sub-block") options.minimumSubBlockSize = value.getIntValue();
+            else if (arg == "--voice-rate")   options.voiceRate = value.getIntValue();
+            else if (arg == "--noise")
+            {
+                if (! parseNoiseColour (value, options.noiseColour))
+                {
+                    error = "Unknown noise colour " + value;
+                    return false;
+                }
+            }
+            else if (arg == "--seed")         options.seed = (uint32) value.getLargeIntValue();
+            else if (arg == "--cache")
+            {
+                options.useCache = true;
+                options.cacheDirectory = value == "memory" ? File() : File::getCurrentWorkingDirectory().getChildFile (value);
+            }
+            else if (arg == "--cache-memory") options.cacheMemoryMegabytes = value.getIntValue();
+            else if (arg == "--multitimbral") options.multitimbral = value.getIntValue() != 0;
+            else if (arg == "--part")
+            {
+                if (! parsePartSettings (value, options.partSettings))
+                {
+                    error = "Can't read the part settings " + value;
+                    return false;
+                }
+            }
+            else if (arg == "--part-voices")
+            {
+                int partIndex;
+                String limit;
+
+                if (! parsePartPrefix (value, partIndex, limit))
+                {
+                    error = "Can't read the part voice limit " + value;
+                    return false;
+                }
+
+                options.partVoiceLimits[partIndex] = limit.getIntValue();
+            }
+            else if (arg == "--mod")
+            {
+                ModulationMatrix::Route route;
+
+                if (! ModulationMatrix::parseRoute (value, route))
+                {
+                    error = "Can't read the modulation route " + value;
+                    return false;
+                }
+
+                options.modulationRoutes.push_back (route);
+            }
+            else if (arg == "--control-interval") options.controlInterval = value.getIntValue();
+            else if (arg == "--velocity-curve")
+            {
+                if (! parseVelocityCurve (value, options.velocityCurve))
+                {
+                    error = "Unknown velocity curve " + value;
+                    return false;
+                }
+            }
+            else if (arg == "--velocity-points")
+            {
+                if (! VelocityCurve::parsePoints (value, options.velocityPoints))
+                {
+                    error = "Can't read the velocity curve points " + value;
+                    return false;
+                }
+            }
+            else if (arg == "--velocity-q")   options.velocityQ = value.getFloatValue();
+            else if (arg == "--bits")         options.bitsPerSample = value.getIntValue();
+            else if (arg == "--tail")         options.tailSeconds = value.getDoubleValue();
+            else
+            {
+                error = "Unknown option " + arg;
+                return false;
+            }
+        }
+
+        auto hasPartOptions = ! options.partSettings.empty()
+                               || std::any_of (std::begin (options.partVoiceLimits), std::end (options.partVoiceLimits),
+                                               [] (int limit) { return limit != SynthAudioSource::maxPolyphony; });
+
+        if (options.input == File() || options.output == File())
+            error = "Both --input and --output are required";
+        else if (! options.input.existsAsFile())
+            error = "Can't find " + options.input.getFullPathName();
+        else if (options.sampleRate <= 0.0 || options.blockSize <= 0 || options.polyphony <= 0)
+            error = "Sample rate, block size and polyphony must be positive";
+        else if (options.polyphony > SynthAudioSource::maxPolyphony)
+            error = "Polyphony can't be more than " + String (SynthAudioSource::maxPolyphony);
+        else if (options.threads < 0)
+            error = "Thread count can't be negative";
+        else if (options.q <= 0.0)
+            error = "Q must be positive";
+        else if (options.minimumSubBlockSize <= 0)
+            error = "The minimum sub-block size must be positive";
+        else if (options.voiceRate != 1 && options.voiceRate != 2 && options.voiceRate != 4)
+            error = "The voice rate must be 1, 2 or 4";
+        else if (options.useCache && options.filterEngine == SynthAudioSource::FilterEngine::resonators)
+            error = "Cached notes are rendered on their own, so they can't share resonators";
+        else if (options.cacheMemoryMegabytes <= 0)
+            error = "The cache's memory size must be positive";
+        else if (options.useCache && options.multitimbral)
+            error = "Cached notes only play the one patch, so the cache can't be used with --multitimbral";
+        else if (hasPartOptions && ! options.multitimbral)
+            error = "--part and --part-voices need --multitimbral 1";
+        else if (options.modulationRoutes.size() > (size_t) ModulationMatrix::numSlots)
+            error = "No more than " + String (ModulationMatrix::numSlots) + " modulation routes";
+        else if (options.useCache && ! options.modulationRoutes.empty())
+            error = "Cached notes are rendered without their controllers, so the cache can't be used with --mod";
+        else if (options.controlInterval < 1 || options.controlInterval > SynthAudioSource::maxControlInterval)
+            error = "The control interval must be 1 to " + String (SynthAudioSource::maxControlInterval);
+        else if (! options.velocityPoints.isEmpty() && options.velocityCurve != VelocityCurve::Shape::custom)
+            error = "--velocity-points needs --velocity-curve custom";
+        else if (options.velocityCurve == VelocityCurve::Shape::custom && options.velocityPoints.isEmpty())
+            error = "--velocity-curve custom needs --velocity-points";
+        else if (options.useCache && options.velocityCurve == VelocityCurve::Shape::custom)
+            error = "Cached notes are only keyed by the fixed velocity curves, so the cache can't be used with a custom one";
+        else if (std::abs (options.velocityQ) > SynthParameters::getDefinition (SynthParameters::velocityQ).maximum)
+            error = "The velocity Q must be -4 to 4 octaves";
+        else if (options.velocityQ != 0.0f && options.filterEngine != SynthAudioSource::FilterEngine::perVoice
+                  && options.topology == SynthAudioSource::FilterTopology::biquad && ! options.multitimbral)
+            error = "The SIMD bank and the resonators run one Q for every voice, so --velocity-q needs --filter voice, "
+                    "another --topology or --multitimbral 1";
+
+        return error.isEmpty();
+    }
+
+    //merges every track into one time-ordered sequence with timestamps in seconds
+    bool loadMidiFile (const File& file, MidiMessageSequence& sequence, String& error)
+    {
+        FileInputStream stream (file);
+        MidiFile midiFile;
+
+        if (! stream.openedOk() || ! midiFile.readFrom (stream))
+        {
+            error = "Can't read a MIDI file from " + file.getFullPathName();
+            return false;
+        }
+
+        midiFile.convertTimestampTicksToSeconds();
+
+        for (int i = 0; i < midiFile.getNumTracks(); ++i)
+            sequence.addSequence (*midiFile.getTrack (i), 0.0);
+
+        //so the cache can find each note's length
+        sequence.updateMatchedPairs();
+        return true;
+    }
+
+    std::unique_ptr<AudioFormatWriter> createWriter (const RenderOptions& options, String& error)
+    {
+        AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        auto* format = formatManager.findFormatForFileExtension (options.output.getFileExtension());
+
+        if (format == nullptr)
+        {
+            error = "Unsupported output format " + options.output.getFileExtension();
+            return {};
+        }
+
+        options.output.deleteFile();
+        std::unique_ptr<FileOutputStream> stream (options.output.createOutputStream());
+
+        if (stream == nullptr)
+        {
+            error = "Can't write to " + options.output.getFullPathName();
+            return {};
+        }
+
+        std::unique_ptr<AudioFormatWriter> writer (format->createWriterFor (stream.get(), options.sampleRate,
+                                                                            CHANNELS, options.bitsPerSample,
+                                                                            {}, 0));
+        if (writer == nullptr)
+        {
+            error = "Can't create a " + format->getFormatName() + " writer for these settings";
+            return {};
+        }
+
+        stream.release(); //the writer owns the stream now
+        return writer;
+    }
+
+    //==============================================================================
+    //--cache: rather than driving the synth, every note is looked up in the cache, or rendered on
+    //its own and added to it, and the segments are mixed in at their note-on times. each note
+    //plays to its own note-off and through its release whatever the polyphony, as if it had a
+    //voice to itself, and the filters are always the per-voice ones
+    class CachedNotePlayer
+    {
+    public:
+        CachedNotePlayer (const MidiMessageSequence& sequence, const RenderOptions& options,
+                          const SynthParameters& parameters, RenderCache& renderCache)
+            : cache (renderCache)
+        {
+            for (int i = 0; i < sequence.getNumEvents(); ++i)
+            {
+                auto& message = sequence.getEventPointer (i)->message;
+
+                if (! message.isNoteOn())
+                    continue;
+
+                //a note that is never released is held to the end of the file
+                auto offIndex = sequence.getIndexOfMatchingKeyUp (i);
+                auto offTime = offIndex >= 0 ? sequence.getEventTime (offIndex) : sequence.getEndTime();
+                auto start = (int64) std::llround (message.getTimeStamp() * options.sampleRate);
+                auto end = (int64) std::llround (offTime * options.sampleRate);
+
+                RenderCache::NoteKey key;
+                key.sampleRate = options.sampleRate;
+                key.lengthInSamples = jmax ((int64) 0, end - start);
+                key.velocity = message.getFloatVelocity();
+                key.q = parameters.getValue (SynthParameters::q);
+                key.spread = parameters.getValue (SynthParameters::spread);
+                key.attack = parameters.getValue (SynthParameters::attack);
+                key.decay = parameters.getValue (SynthParameters::decay);
+                key.sustain = parameters.getValue (SynthParameters::sustain);
+                key.release = parameters.getValue (SynthParameters::release);
+                key.midiNoteNumber = message.getNoteNumber();
+                key.voiceRate = options.voiceRate;
+                key.topology = (int32) options.topology;
+                key.panLaw = (int32) options.panLaw;
+                key.noiseColour = (int32) options.noiseColour;
+                key.stereoNoise = options.stereoNoise ? 1 : 0;
+                key.noiseSeed = options.seed;
+                key.velocityCurve = (int32) roundToInt (parameters.getValue (SynthParameters::velocityCurve));
+                key.velocityQ = parameters.getValue (SynthParameters::velocityQ);
+
+                notes.push_back ({ start, key });
+            }
+        }
+
+        //replaces the block's contents with every cached note sounding in it
+        void render (AudioBuffer<float>& buffer, int64 blockStart, int numSamples)
+        {
+            auto blockEnd = blockStart + numSamples;
+
+            for (; nextNote < notes.size() && notes[nextNote].start < blockEnd; ++nextNote)
+            {
+                auto& note = notes[nextNote];
+                auto segment = cache.find (note.key);
+
+                if (segment == nullptr)
+                {
+                    segment = renderer.render (note.key);
+                    cache.add (note.key, segment);
+                }
+
+                sounding.push_back ({ note.start, std::move (segment) });
+            }
+
+            buffer.clear (0, numSamples);
+
+            for (auto& note : sounding)
+            {
+                auto offset = (int) (blockStart - note.start);
+                auto outputStart = jmax (0, -offset);
+
+                note.segment->addTo (buffer, outputStart, jmax (0, offset), numSamples - outputStart);
+            }
+
+            sounding.erase (std::remove_if (sounding.begin(), sounding.end(), [blockEnd] (const SoundingNote& note)
+                                            {
+                                                return note.start + note.segment->getNumSamples() <= blockEnd;
+                                            }),
+                            sounding.end());
+        }
+
+    private:
+        struct Note
+        {
+            int64 start;
+            RenderCache::NoteKey key;
+        };
+
+        struct SoundingNote
+        {
+            int64 start;
+            std::shared_ptr<const RenderCache::Segment> segment;
+        };
+
+        RenderCache& cache;
+        NoteRenderer renderer;
+        std::vector<Note> notes;
+        std::vector<SoundingNote> sounding;
+        size_t nextNote = 0;
+    };
+
+    void printCacheStatistics (const RenderCache& cache)
+    {
+        auto& statistics = cache.getStatistics();
+        auto numNotes = statistics.memoryHits + statistics.diskHits + statistics.misses;
+        auto hitRate = 100.0 * (double) (statistics.memoryHits + statistics.diskHits) / (double) jmax ((int64) 1, numNotes);
+
+        std::cout << "Render cache: " << numNotes << " notes, " << statistics.memoryHits << " from memory, "
+                  << statistics.diskHits << " from disk, " << statistics.misses << " rendered ("
+                  << hitRate << "% hits), " << statistics.evictions << " evicted from memory" << std::endl;
+
+        if (statistics.diskWriteFailures > 0)
+            std::cerr << "Couldn't write " << statistics.diskWriteFailures << " notes to the cache directory" << std::endl;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    StringArray args;
+
+    for (int i = 1; i < argc; ++i)
+        args.add (argv[i]);
+
+    RenderOptions options;
+    MidiMessageSequence sequence;
+    String error;
+
+    if (args.isEmpty())
+    {
+        printUsage();
+        return 0;
+    }
+
+    if (! parseOptions (args, options, error) || ! loadMidiFile (options.input, sequence, error))
+    {
+        std::cerr << error << std::endl;
+        printUsage();
+        return 1;
+    }
+
+    auto writer = createWriter (options, error);
+
+    if (writer == nullptr)
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    SynthAudioSource synthSource (options.polyphony);
+    synthSource.setStealingPolicy (options.stealingPolicy);
+    synthSource.setFilterEngine (options.filterEngine);
+    synthSource.setPanLaw (options.panLaw);
+    synthSource.setStereoNoise (options.stereoNoise);
+    synthSource.setMinimumSubBlockSize (options.minimumSubBlockSize);
+    synthSource.setOversamplingFactor (options.voiceRate);
+    synthSource.setNoiseSeed (options.seed);
+    synthSource.setControlInterval (options.controlInterval);
+
+    for (size_t slot = 0; slot < options.modulationRoutes.size(); ++slot)
+        synthSource.getModulationMatrix().setRoute ((int) slot, options.modulationRoutes[slot]);
+
+    if (! options.velocityPoints.isEmpty())
+        synthSource.getVelocityCurve().setCustomPoints (options.velocityPoints);
+
+    VoiceRenderScheduler::Options renderOptions;
+    renderOptions.numWorkers = options.threads;
+    synthSource.setRenderOptions (renderOptions);
+
+    //--gain stands in for the GUI's volume slider, which tops out at 1
+    synthSource.getParameters().setValue (SynthParameters::q, (float) options.q);
+    synthSource.getParameters().setValue (SynthParameters::volume, 1.0f);
+    synthSource.getParameters().setValue (SynthParameters::spread, options.spread);
+    synthSource.getParameters().setValue (SynthParameters::filterType, (float) options.topology);
+    synthSource.getParameters().setValue (SynthParameters::noiseColour, (float) options.noiseColour);
+    synthSource.getParameters().setValue (SynthParameters::velocityCurve, (float) options.velocityCurve);
+    synthSource.getParameters().setValue (SynthParameters::velocityQ, options.velocityQ);
+
+    //every part starts from the patch the options above set, then takes its own --part settings
+    if (options.multitimbral)
+    {
+        synthSource.setMultitimbral (true);
+
+        for (int part = 0; part < SynthAudioSource::numParts; ++part)
+        {
+            for (int i = 0; i < SynthParameters::numParameters; ++i)
+                synthSource.getPartParameters (part).setValue (i, synthSource.getParameters().getValue (i));
+
+            synthSource.setPartVoiceLimit (part, options.partVoiceLimits[part]);
+        }
+
+        for (auto& setting : options.partSettings)
+            synthSource.getPartParameters (setting.partIndex).setValue (setting.parameterIndex, setting.value);
+    }
+
+    synthSource.prepareToPlay (options.blockSize, options.sampleRate);
+
+    OutputStage outputStage;
+    outputStage.setClipMode (options.clipMode);
+    outputStage.setOversampled (options.oversample);
+    outputStage.prepare (options.blockSize, CHANNELS);
+
+    //the file isn't shifted to make up for it
+    auto latency = synthSource.getLatencyInSamples() + outputStage.getLatencyInSamples();
+
+    if (latency > 0.0f)
+        std::cout << "Oversampling delays the output by " << latency << " samples" << std::endl;
+
+    std::unique_ptr<RenderCache> cache;
+    std::unique_ptr<CachedNotePlayer> cachedNotes;
+
+    if (options.useCache)
+    {
+        cache.reset (new RenderCache ((size_t) options.cacheMemoryMegabytes << 20, options.cacheDirectory));
+        cachedNotes.reset (new CachedNotePlayer (sequence, options, synthSource.getParameters(), *cache));
+    }
+
+    AudioBuffer<float> buffer (CHANNELS, options.blockSize);
+    MidiBuffer midi;
+    midi.ensureSize (4096);
+
+    auto totalSamples = (int64) std::ceil ((sequence.getEndTime() + options.tailSeconds) * options.sampleRate);
+    auto startTime = Time::getMillisecondCounterHiRes();
+    int eventIndex = 0;
+
+    for (int64 blockStart = 0; blockStart < totalSamples; blockStart += options.blockSize)
+    {
+        auto numThisTime = (int) jmin ((int64) options.blockSize, totalSamples - blockStart);
+        auto blockEnd = blockStart + numThisTime;
+
+        if (cachedNotes != nullptr)
+        {
+            cachedNotes->render (buffer, blockStart, numThisTime);
+        }
+        else
+        {
+            midi.clear();
+
+            for (; eventIndex < sequence.getNumEvents(); ++eventIndex)
+            {
+                auto& message = sequence.getEventPointer (eventIndex)->message;
+                auto samplePosition = (int64) std::llround (message.getTimeStamp() * options.sampleRate);
+
+                if (samplePosition >= blockEnd)
+                    break;
+
+                if (! message.isMetaEvent())
+                    midi.addEvent (message, (int) jmax ((int64) 0, samplePosition - blockStart));
+            }
+
+            synthSource.renderNextBlock (buffer, midi, 0, numThisTime);
+        }
+
+        float startGain, endGain;
+        synthSource.advanceOutputGain (numThisTime, startGain, endGain);
+        outputStage.process (buffer, 0, numThisTime, startGain * options.gain, endGain * options.gain);
+
+        writer->writeFromAudioSampleBuffer (buffer, 0, numThisTime);
+    }
+
+    writer.reset(); //flushes and closes the file
+
+    auto seconds = (Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+    auto audioSeconds = (double) totalSamples / options.sampleRate;
+
+    std::cout << "Rendered " << audioSeconds << " s of audio to " << options.output.getFullPathName()
+              << " in " << seconds << " s (" << audioSeconds / jmax (seconds, 1.0e-9) << "x real time)" << std::endl;
+
+    if (cache != nullptr)
+        printCacheStatistics (*cache);
+
+    synthSource.releaseResources();
+    return 0;
+}
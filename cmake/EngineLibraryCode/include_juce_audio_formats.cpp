@@ -0,0 +1,7 @@
+/*
+    File: include_juce_audio_formats.cpp
+    Description: Builds the juce_audio_formats module into the engine library with this AppConfig.h.
+*/
+
+#include "AppConfig.h"
+#include <juce_audio_formats/juce_audio_formats.cpp>
@@ -0,0 +1,7 @@
+/*
+    File: include_juce_core.cpp
+    Description: Builds the juce_core module into the engine library with this AppConfig.h.
+*/
+
+#include "AppConfig.h"
+#include <juce_core/juce_core.cpp>
@@ -0,0 +1,7 @@
+/*
+    File: include_juce_data_structures.cpp
+    Description: Builds the juce_data_structures module into the engine library with this AppConfig.h.
+*/
+
+#include "AppConfig.h"
+#include <juce_data_structures/juce_data_structures.cpp>
@@ -0,0 +1,7 @@
+/*
+    File: include_juce_dsp.cpp
+    Description: Builds the juce_dsp module into the engine library with this AppConfig.h.
+*/
+
+#include "AppConfig.h"
+#include <juce_dsp/juce_dsp.cpp>
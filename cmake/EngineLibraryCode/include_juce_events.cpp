@@ -0,0 +1,7 @@
+/*
+    File: include_juce_events.cpp
+    Description: Builds the juce_events module into the engine library with this AppConfig.h.
+*/
+
+#include "AppConfig.h"
+#include <juce_events/juce_events.cpp>
@@ -0,0 +1,150 @@
+# File: SynthTargets.cmake
+# Description: The functions behind CMakeLists.txt. JUCE modules are compiled the way the
+# Projucer's makefiles do it: one translation unit per module, through include_juce_*.cpp
+# wrappers that sit next to the AppConfig.h they are configured by. The non-GUI modules are
+# built once per engine with cmake/EngineLibraryCode; the GUI application adds the rest of its
+# modules with its own JuceLibraryCode.
+
+find_package (Threads REQUIRED)
+find_package (ALSA)
+
+if (NOT ALSA_FOUND AND SYNTH_BUILD_GUI)
+    message (WARNING "ALSA wasn't found, so the GUI application will have no audio device")
+endif()
+
+set (SYNTH_HEADLESS_MODULES
+    juce_audio_basics juce_audio_devices juce_audio_formats juce_core
+    juce_data_structures juce_dsp juce_events)
+
+set (SYNTH_GUI_MODULES
+    juce_audio_processors juce_audio_utils juce_cryptography juce_graphics
+    juce_gui_basics juce_gui_extra juce_opengl juce_video)
+
+set (SYNTH_ENGINE_SOURCES
+    Source/AllocationGuard.cpp
+    Source/BandPassCoefficientCache.cpp
+    Source/Decimator.cpp
+    Source/EnvelopeGenerator.cpp
+    Source/MidiEventQueue.cpp
+    Source/ModulationMatrix.cpp
+    Source/NoiseGenerator.cpp
+    Source/NoteRenderer.cpp
+    Source/OutputStage.cpp
+    Source/ParallelSynthesiser.cpp
+    Source/PerformanceMonitor.cpp
+    Source/RenderCache.cpp
+    Source/ResonatorBank.cpp
+    Source/SynthEngine.cpp
+    Source/SynthParameters.cpp
+    Source/VelocityCurve.cpp
+    Source/VoiceFilter.cpp
+    Source/VoiceFilterBank.cpp
+    Source/VoiceRenderScheduler.cpp)
+
+math (EXPR SYNTH_VERSION_HEX
+      "(${PROJECT_VERSION_MAJOR} << 16) | (${PROJECT_VERSION_MINOR} << 8) | ${PROJECT_VERSION_PATCH}"
+      OUTPUT_FORMAT HEXADECIMAL)
+
+function (synth_set_arch target arch)
+    if (arch)
+        target_compile_options (${target} PRIVATE "-march=${arch}")
+    endif()
+endfunction()
+
+#==============================================================================
+# synth_juce_headless<suffix> and SynthEngine<suffix>, compiled for -march=<arch>
+function (synth_add_engine suffix arch)
+    set (juce synth_juce_headless${suffix})
+    set (engine SynthEngine${suffix})
+    set (juceSources)
+
+    foreach (module IN LISTS SYNTH_HEADLESS_MODULES)
+        list (APPEND juceSources "${PROJECT_SOURCE_DIR}/cmake/EngineLibraryCode/include_${module}.cpp")
+    endforeach()
+
+    add_library (${juce} STATIC ${juceSources})
+    target_include_directories (${juce} PUBLIC
+        "${PROJECT_SOURCE_DIR}/cmake/EngineLibraryCode"
+        "${JUCE_DIR}/modules")
+    target_compile_definitions (${juce} PUBLIC
+        JUCE_APP_VERSION=${PROJECT_VERSION}
+        JUCE_APP_VERSION_HEX=${SYNTH_VERSION_HEX}
+        JUCE_ALSA=$<BOOL:${ALSA_FOUND}>
+        JUCE_JACK=0
+        JUCE_USE_CURL=0)
+    target_link_libraries (${juce} PUBLIC Threads::Threads ${CMAKE_DL_LIBS} rt)
+
+    if (ALSA_FOUND)
+        target_link_libraries (${juce} PUBLIC ALSA::ALSA)
+    endif()
+
+    synth_set_arch (${juce} "${arch}")
+
+    list (TRANSFORM SYNTH_ENGINE_SOURCES PREPEND "${PROJECT_SOURCE_DIR}/" OUTPUT_VARIABLE engineSources)
+    add_library (${engine} STATIC ${engineSources})
+    target_include_directories (${engine} PUBLIC "${PROJECT_SOURCE_DIR}/Source")
+    target_link_libraries (${engine} PUBLIC ${juce})
+    synth_set_arch (${engine} "${arch}")
+
+    if (SYNTH_CPU_DISPATCH)
+        target_compile_definitions (${engine} PRIVATE SYNTH_CPU_DISPATCH=1)
+    endif()
+
+    set_target_properties (${engine} PROPERTIES SYNTH_ARCH "${arch}")
+endfunction()
+
+#==============================================================================
+# OfflineRender<suffix> and Benchmark<suffix>, linked against SynthEngine<suffix>
+function (synth_add_tools suffix)
+    set (engine SynthEngine${suffix})
+    get_target_property (arch ${engine} SYNTH_ARCH)
+
+    foreach (tool OfflineRender Benchmark)
+        set (target ${tool}${suffix})
+        add_executable (${target} "${PROJECT_SOURCE_DIR}/Tools/${tool}/Source/Main.cpp")
+
+        # <JuceHeader.h> in the engine headers has to resolve to the tool's own copy
+        target_include_directories (${target} PRIVATE "${PROJECT_SOURCE_DIR}/Tools/${tool}/JuceLibraryCode")
+        target_link_libraries (${target} PRIVATE ${engine})
+        synth_set_arch (${target} "${arch}")
+    endforeach()
+
+    # allocations are counted by the engine's heap hooks, which release builds leave out. the
+    # benchmark compiles its own AllocationGuard.cpp with them switched on; its object defines
+    # every symbol the library's copy would, so the library's is never pulled in
+    target_sources (Benchmark${suffix} PRIVATE "${PROJECT_SOURCE_DIR}/Source/AllocationGuard.cpp")
+    target_compile_definitions (Benchmark${suffix} PRIVATE SYNTH_COUNT_ALLOCATIONS=1)
+endfunction()
+
+#==============================================================================
+# synth_juce_gui (the GUI-only modules) and the SubtractiveSynthApp executable
+function (synth_add_gui_app)
+    find_package (PkgConfig REQUIRED)
+    find_package (OpenGL REQUIRED)
+    pkg_check_modules (SYNTH_X11 REQUIRED IMPORTED_TARGET freetype2 x11 xext xinerama xrandr xcursor)
+
+    set (juceSources)
+
+    foreach (module IN LISTS SYNTH_GUI_MODULES)
+        list (APPEND juceSources "${PROJECT_SOURCE_DIR}/JuceLibraryCode/include_${module}.cpp")
+    endforeach()
+
+    add_library (synth_juce_gui STATIC ${juceSources})
+    target_include_directories (synth_juce_gui PUBLIC "${PROJECT_SOURCE_DIR}/JuceLibraryCode")
+
+    # the web browser component would pull in WebKitGTK, and nothing here uses it
+    target_compile_definitions (synth_juce_gui PUBLIC JUCE_WEB_BROWSER=0)
+    target_link_libraries (synth_juce_gui PUBLIC synth_juce_headless PkgConfig::SYNTH_X11 OpenGL::GL)
+    synth_set_arch (synth_juce_gui "${SYNTH_ARCH}")
+
+    add_executable (SubtractiveSynthApp
+        "${PROJECT_SOURCE_DIR}/Source/Main.cpp"
+        "${PROJECT_SOURCE_DIR}/Source/MainComponent.cpp"
+        "${PROJECT_SOURCE_DIR}/Source/PerformanceServer.cpp"
+        "${PROJECT_SOURCE_DIR}/Source/SignalAnalyser.cpp")
+
+    # the app's JuceLibraryCode has to come before the engine's for <JuceHeader.h>
+    target_include_directories (SubtractiveSynthApp PRIVATE "${PROJECT_SOURCE_DIR}/JuceLibraryCode")
+    target_link_libraries (SubtractiveSynthApp PRIVATE synth_juce_gui SynthEngine)
+    synth_set_arch (SubtractiveSynthApp "${SYNTH_ARCH}")
+endfunction()